@@ -10,6 +10,8 @@ from util import cache
 import sprite_sheets
 import argparse
 import os
+import glob, pickle
+import concurrent.futures, multiprocessing
 
 def flatten(xss):
     return [x for xs in xss for x in xs]
@@ -18,6 +20,19 @@ def invert_dict(xs):
   return {s:i for i,s in xs.items()}
 
 assets = {}
+asset_flags = 0
+
+# Flags stored in the assets file header
+kAssetsFlag_PreExpandedGfx = 1
+kAssetsFlag_OnDemand = 2
+
+# Big assets that are only needed now and then. With --on-demand-assets these
+# get compressed, and the game decompresses them when first used.
+kOnDemandAssets = [
+  'kSoundBank_intro', 'kSoundBank_indoor', 'kSoundBank_ending',
+  'kDialogue', 'kDialogueFont', 'kOverworldMapGfx', 'kDungMap_Tiles',
+  'kEnding_Credits_Text', 'kEnding_MapData', 'kEnding0_Data',
+]
 
 def add_asset_uint8(name, data):
   assert name not in assets
@@ -98,24 +113,50 @@ def pack_arrays(arr):
   else:
     return b''.join([struct.pack('I', i) for i in all_offs] + arr + [struct.pack('H', 8192 + len(arr) - 1)])
 
+# Expands a 3bpp sheet into the 4bpp tiles that Do3To4High / Do3To4Low
+# write to vram. The high variant sets the 4th plane wherever a pixel is nonzero.
+def expand_3bpp_sheet(raw, high):
+  out = bytearray()
+  for j in range(64):
+    tile = raw[j * 24 : j * 24 + 24]
+    out += tile[:16]
+    for r in range(8):
+      d = tile[16 + r]
+      out += bytes([d, (tile[2 * r] | tile[2 * r + 1] | d) if high else 0])
+  return bytes(out)
+
+# The sheet as the game loads it: decompressed, and if it's a 3bpp sheet,
+# followed by both of its 4bpp expansions.
+def pre_expand_sheet(raw):
+  raw = bytes(raw)
+  if len(raw) != 0x600:
+    return raw
+  return raw + expand_3bpp_sheet(raw, True) + expand_3bpp_sheet(raw, False)
+
 def print_images(args):
+  global asset_flags
   sprsheet = sprite_sheets.load_sprite_sheets() if args.sprites_from_png else None
+  pre_expand = getattr(args, 'pre_expanded_gfx', False)
+  if pre_expand:
+    asset_flags |= kAssetsFlag_PreExpandedGfx
 
   all = []
   for i in range(108):
     if sprsheet != None and i < 103:
-      all.append(sprsheet.encode_sheet_in_snes_format(i))
+      data = sprsheet.encode_sheet_in_snes_format(i)
+      all.append(pre_expand_sheet(data) if pre_expand else data)
     elif i < 12:
-      all.append(bytes(ROM.get_bytes(tables.kCompSpritePtrs[i], 0x600)))   
+      data = bytes(ROM.get_bytes(tables.kCompSpritePtrs[i], 0x600))
+      all.append(pre_expand_sheet(data) if pre_expand else data)
     else:
       decomp, comp_len = util.decomp(tables.kCompSpritePtrs[i], ROM.get_byte, False, True)
-      all.append(bytes(ROM.get_bytes(tables.kCompSpritePtrs[i], comp_len)))
+      all.append(pre_expand_sheet(decomp) if pre_expand else bytes(ROM.get_bytes(tables.kCompSpritePtrs[i], comp_len)))
   add_asset_packed('kSprGfx', all)
 
   all = []
   for i in range(len(tables.kCompBgPtrs)):
     decomp, comp_len = util.decomp(tables.kCompBgPtrs[i], ROM.get_byte, False, True)
-    all.append(bytes(ROM.get_bytes(tables.kCompBgPtrs[i], comp_len)))
+    all.append(pre_expand_sheet(decomp) if pre_expand else bytes(ROM.get_bytes(tables.kCompBgPtrs[i], comp_len)))
   add_asset_packed('kBgGfx', all)
 
 def print_dialogue(args):
@@ -753,24 +794,99 @@ def print_sound_banks():
     name, data = compile_music.print_song(song)
     add_asset_uint8(name, data)
 
+# The assets are built in stages, in this order. The output of each stage is
+# cached in build_cache/ along with a hash of everything it reads: the ROM, the
+# scripts, the options and the input files listed here. Only the stages whose
+# hash changed get rerun, in parallel where fork is available.
+kStages = [
+  ('sound_banks', lambda args: print_sound_banks(), ['music_info.yaml', 'sfx.txt', 'sound_*.txt', 'sound/*']),
+  ('dungeon_rooms', lambda args: print_dungeon_rooms(), ['dungeon/*.yaml']),
+  ('enemy_damage_data', lambda args: print_enemy_damage_data(), []),
+  ('link_graphics', lambda args: print_link_graphics(), ['linksprite.png']),
+  ('dungeon_sprites', lambda args: print_dungeon_sprites(), ['dungeon/*.yaml']),
+  ('map32_to_map16', lambda args: print_map32_to_map16(), ['map32_to_map16.txt']),
+  ('images', print_images, ['sprites/*.png']),
+  ('misc', print_misc, []),
+  ('dialogue', print_dialogue, ['dialogue*.txt', 'font*.png']),
+  ('dungeon_map', lambda args: print_dungeon_map(), []),
+  ('tilemaps', lambda args: print_tilemaps(), []),
+  ('overworld', lambda args: print_overworld(), []),
+  ('overworld_tables', lambda args: print_overworld_tables(), ['overworld/*.yaml']),
+]
+
+def stage_hash(inputs, stage_args):
+  h = hashlib.sha256(ROM.ROM)
+  for pattern in ['*.py'] + inputs:
+    for fname in sorted(glob.glob(pattern)):
+      h.update(fname.encode('utf8') + b'\0' + open(fname, 'rb').read())
+  h.update(repr(sorted(vars(stage_args).items())).encode('utf8'))
+  return h.hexdigest()
+
+def run_stage(i, stage_args):
+  global assets, asset_flags
+  assets, asset_flags = {}, 0
+  kStages[i][1](stage_args)
+  return assets, asset_flags
+
 def print_all(args):
-  print_sound_banks()
-  print_dungeon_rooms()
-  print_enemy_damage_data()
-  print_link_graphics()
-  print_dungeon_sprites()
-  print_map32_to_map16()
-  print_images(args)
-  print_misc(args)
-  print_dialogue(args)
-  print_dungeon_map()
-  print_tilemaps()
-  print_overworld()
-  print_overworld_tables()
-
-def write_assets_to_file(print_header = False):
+  global assets, asset_flags
+  # Only the options that affect the stages
+  stage_args = argparse.Namespace(sprites_from_png = args.sprites_from_png, languages = args.languages,
+                                  pre_expanded_gfx = getattr(args, 'pre_expanded_gfx', False))
+  use_cache = not getattr(args, 'no_cache', False)
+  results, todo = {}, []
+  for i, (name, func, inputs) in enumerate(kStages):
+    key = stage_hash(inputs, stage_args)
+    cache_file = os.path.join('build_cache', name + '.pickle')
+    if use_cache and os.path.exists(cache_file):
+      cached_key, result = pickle.load(open(cache_file, 'rb'))
+      if cached_key == key:
+        results[i] = result
+        continue
+    todo.append((i, key, cache_file))
+  if todo:
+    print('Building %s' % ', '.join(kStages[i][0] for i, _, _ in todo))
+
+  def store(i, key, cache_file, result):
+    results[i] = result
+    if use_cache:
+      os.makedirs('build_cache', exist_ok = True)
+      pickle.dump((key, result), open(cache_file + '.tmp', 'wb'))
+      os.replace(cache_file + '.tmp', cache_file)
+
+  # Workers are forked so that they share the loaded ROM. Where that's not
+  # available the stages run one after another.
+  jobs = min(len(todo), getattr(args, 'jobs', None) or os.cpu_count() or 1)
+  if jobs > 1 and 'fork' in multiprocessing.get_all_start_methods():
+    with concurrent.futures.ProcessPoolExecutor(jobs, mp_context = multiprocessing.get_context('fork')) as executor:
+      futures = [(i, key, cache_file, executor.submit(run_stage, i, stage_args)) for i, key, cache_file in todo]
+      for i, key, cache_file, future in futures:
+        store(i, key, cache_file, future.result())
+  else:
+    for i, key, cache_file in todo:
+      store(i, key, cache_file, run_stage(i, stage_args))
+
+  assets, asset_flags = {}, 0
+  for i in range(len(kStages)):
+    stage_assets, stage_flags = results[i]
+    for k, v in stage_assets.items():
+      assert k not in assets
+      assets[k] = v
+    asset_flags |= stage_flags
+
+def compress_on_demand_asset(data):
+  r = bytearray(struct.pack('I', len(data)))
+  for i in range(0, len(data), 0x10000):
+    c = util.comp(data[i:i+0x10000], False)
+    c += bytes(-len(c) & 3)  # keep the chunk sizes aligned
+    r += struct.pack('I', len(c)) + c
+  return bytes(r)
+
+def write_assets_to_file(print_header = False, on_demand = False):
+  global asset_flags
   key_sig = b''
   all_data = []
+  on_demand_bitmap = bytearray(24)
   if print_header:
     print('''#pragma once
 #include "types.h"
@@ -781,16 +897,40 @@ enum {
 extern const uint8 *g_asset_ptrs[kNumberOfAssets];
 extern uint32 g_asset_sizes[kNumberOfAssets];
 extern MemBlk FindInAssetArray(int asset, int idx);
-''' % len(assets))
+extern uint8 g_asset_flags;
+
+enum {
+  kAssetsFlag_PreExpandedGfx = %d,
+  kAssetsFlag_OnDemand = %d,
+};
+
+void LoadAssetsFromMemory(const uint8 *data, size_t length);
+const uint8 *LoadOnDemandAsset(int asset);
+void ReclaimOnDemandAssets();
+MemBlk PinAssetBlk(MemBlk blk);
+
+// Assets that are stored compressed have no pointer until they're first used.
+static inline const uint8 *AssetPtr(int asset) {
+  const uint8 *p = g_asset_ptrs[asset];
+  return p ? p : LoadOnDemandAsset(asset);
+}
+''' % (len(assets), kAssetsFlag_PreExpandedGfx, kAssetsFlag_OnDemand))
 
   for i, (k, (tp, data)) in enumerate(assets.items()):
     if print_header:
       if tp == 'packed':
         print('#define %s(idx) FindInAssetArray(%d, idx)' % (k, i))
       else:
-        print('#define %s ((%s*)g_asset_ptrs[%d])' % (k, tp, i))
+        print('#define %s ((%s*)AssetPtr(%d))' % (k, tp, i))
         print('#define %s_SIZE (g_asset_sizes[%d])' % (k, i))
     key_sig += k.encode('utf8') + b'\0'
+    if on_demand and k in kOnDemandAssets:
+      c = compress_on_demand_asset(data)
+      if len(c) < len(data):
+        assert i < len(on_demand_bitmap) * 8
+        on_demand_bitmap[i >> 3] |= 1 << (i & 7)
+        asset_flags |= kAssetsFlag_OnDemand
+        data = c
     all_data.append(data)
 
   assets_sig = b'Zelda3_v0     \n\0' + hashlib.sha256(key_sig).digest()
@@ -798,22 +938,29 @@ extern MemBlk FindInAssetArray(int asset, int idx);
   if print_header:
     print('#define kAssets_Sig %s' % ", ".join((str(a) for a in assets_sig)))
 
-  hdr = assets_sig + b'\x00' * 32 + struct.pack('II', len(all_data), len(key_sig))
+  # The first reserved byte holds log2 of the page size. Assets of at least a
+  # page get page aligned, so that they can be used straight out of a mapping
+  # of the file, and pages that are never touched don't get loaded at all.
+  page_shift = 12
+  page_size = 1 << page_shift
+  # The second one holds the kAssetsFlag bits, and the last 24 a bitmap of the
+  # assets that are stored compressed.
+  hdr = assets_sig + bytes([page_shift, asset_flags]) + b'\x00' * 6 + on_demand_bitmap + struct.pack('II', len(all_data), len(key_sig))
 
   encoded_sizes = array.array('I', [len(i) for i in all_data])
 
-  file_data = hdr + encoded_sizes + key_sig
+  file_data = bytearray(hdr + encoded_sizes + key_sig)
 
   for v in all_data:
-    while len(file_data) & 3:
-      file_data += b'\0'
+    align = page_size if len(v) >= page_size else 4
+    file_data += b'\0' * (-len(file_data) & (align - 1))
     file_data += v
 
   open('../zelda3_assets.dat', 'wb').write(file_data)
 
 def main(args):
   print_all(args)
-  write_assets_to_file(args.print_assets_header)
+  write_assets_to_file(args.print_assets_header, getattr(args, 'on_demand_assets', False))
 
 if __name__ == "__main__":
   ROM = util.load_rom(sys.argv[1] if len(sys.argv) >= 2 else None)
@@ -821,6 +968,10 @@ if __name__ == "__main__":
     sprites_from_png = False
     languages = None
     print_assets_header = False
+    pre_expanded_gfx = False
+    on_demand_assets = False
+    jobs = None
+    no_cache = False
   main(DefaultArgs())
 else:
   ROM = util.ROM
@@ -21,6 +21,14 @@ optional.add_argument('--print-assets-header', action='store_true')
 
 optional = parser.add_argument_group('Image handling')
 optional.add_argument('--sprites-from-png', action='store_true', help="When compiling, load sprites from png instead of from ROM")
+optional.add_argument('--pre-expanded-gfx', action='store_true', help="Store graphics decompressed and expanded to 4bpp. Bigger file, faster loading")
+
+optional = parser.add_argument_group('Build settings')
+optional.add_argument('-j', '--jobs', type=int, metavar='N', help="Number of processes used for building (default: number of cpus)")
+optional.add_argument('--no-cache', action='store_true', help="Rebuild everything instead of only what changed since the last build")
+
+optional = parser.add_argument_group('Memory usage')
+optional.add_argument('--on-demand-assets', action='store_true', help="Compress big rarely used assets such as dialogue and song banks, and decompress them when needed. For low memory targets")
 
 args = parser.parse_args()
 
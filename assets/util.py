@@ -226,6 +226,61 @@ def decomp(ea, rb, offset_is_be = True, return_length = False):
         b = (b + 1) & 0xff
         lx -= 1
 
+# Greedy compressor producing the format that decomp reads.
+def comp(data, offset_is_be = True):
+  data = bytes(data)
+  n, out, chains = len(data), bytearray(), {}
+  def emit(cmd, lx, args):
+    if lx <= 32:
+      out.append(cmd << 5 | (lx - 1))
+    else:
+      out.extend((0xe0 | cmd << 2 | (lx - 1) >> 8, (lx - 1) & 0xff))
+    out.extend(args)
+  def add_chain(j):
+    if j + 3 <= n:
+      chains.setdefault(data[j:j+3], []).append(j)
+  lit_start = i = 0
+  while i < n:
+    maxl = min(n - i, 1024)
+    best_gain, best = 0, None
+    # memset, memset16 and incr runs
+    lx = 1
+    while lx < maxl and data[i + lx] == data[i]: lx += 1
+    if lx - 2 > best_gain: best_gain, best = lx - 2, (1, lx, bytes([data[i]]))
+    if maxl >= 2:
+      lx = 2
+      while lx < maxl and data[i + lx] == data[i + (lx & 1)]: lx += 1
+      if lx - 3 > best_gain: best_gain, best = lx - 3, (2, lx, data[i:i+2])
+    lx = 1
+    while lx < maxl and data[i + lx] == (data[i] + lx) & 0xff: lx += 1
+    if lx - 2 > best_gain: best_gain, best = lx - 2, (3, lx, bytes([data[i]]))
+    # copy, offsets are into the output so far
+    for j in reversed(chains.get(data[i:i+3], [])[-16:]):
+      if j > 0xffff: continue
+      lx = 3
+      while lx < maxl and data[j + lx] == data[i + lx]: lx += 1
+      if lx - 3 > best_gain:
+        offs = bytes([j >> 8, j & 0xff]) if offset_is_be else bytes([j & 0xff, j >> 8])
+        best_gain, best = lx - 3, (4, lx, offs)
+    if best is not None and best_gain > (best[1] > 32):
+      while lit_start < i:
+        lx = min(i - lit_start, 1024)
+        emit(0, lx, data[lit_start:lit_start+lx])
+        lit_start += lx
+      for j in range(i, i + best[1]):
+        add_chain(j)
+      emit(*best)
+      i += best[1]
+      lit_start = i
+    else:
+      add_chain(i)
+      i += 1
+  while lit_start < n:
+    lx = min(n - lit_start, 1024)
+    emit(0, lx, data[lit_start:lit_start+lx])
+    lit_start += lx
+  out.append(0xff)
+  return out
 
 def decode_brr(get_byte, olds = (0, 0)):
   ea=0
@@ -0,0 +1,130 @@
+// Renders music or sound effects from the song banks in zelda3_assets.dat
+// into a wav file, without SDL and as fast as the cpu allows. Useful for
+// benchmarking the audio engine and for checking that a change to it didn't
+// alter the output, by comparing the printed hash against a known good one.
+//
+//   make audio_render
+//   ./audio_render -b indoor -m 16 -t 30 out.wav
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "src/types.h"
+#include "src/util.h"
+#include "src/assets.h"
+#include "src/spc_player.h"
+#include "tool_common.h"
+
+static void NORETURN PrintUsage() {
+  fprintf(stderr,
+    "usage: audio_render [options] [output.wav]\n"
+    "  -a <file>    assets file (default zelda3_assets.dat)\n"
+    "  -b <bank>    song bank: intro, indoor or ending (default intro)\n"
+    "  -m <n>       music track to play, written to apu port 0\n"
+    "  -s <p>:<n>   sound effect n on apu port p (1-3), can be repeated\n"
+    "  -t <secs>    seconds to render (default 10)\n"
+    "  -f <freq>    output frequency (default 32000, the native rate)\n"
+    "  -x <hash>    exit with an error if the output hash differs\n");
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  const char *assets_file = "zelda3_assets.dat", *bank = "intro", *output = NULL;
+  uint8 ports[4] = { 0 }, sfx_ports[4] = { 0 };
+  int seconds = 10, freq = 32000;
+  uint32 expected_hash = 0;
+  bool have_expected_hash = false;
+
+  for (int i = 1; i < argc; i++) {
+    const char *a = argv[i];
+    if (a[0] != '-') {
+      output = a;
+      continue;
+    }
+    if (i + 1 >= argc || a[2] != 0)
+      PrintUsage();
+    const char *v = argv[++i];
+    switch (a[1]) {
+    case 'a': assets_file = v; break;
+    case 'b': bank = v; break;
+    case 'm': ports[0] = strtol(v, NULL, 0); break;
+    case 's': {
+      char *e;
+      int port = strtol(v, &e, 0);
+      if (port < 1 || port > 3 || *e != ':')
+        PrintUsage();
+      sfx_ports[port] = strtol(e + 1, NULL, 0);
+      break;
+    }
+    case 't': seconds = atoi(v); break;
+    case 'f': freq = atoi(v); break;
+    case 'x': expected_hash = strtoul(v, NULL, 16); have_expected_hash = true; break;
+    default: PrintUsage();
+    }
+  }
+  if (seconds <= 0 || freq < 8000 || freq > 48000)
+    PrintUsage();
+
+  LoadAssets(assets_file);
+
+  SpcPlayer *p = SpcPlayer_Create();
+  SpcPlayer_Initialize(p);
+  // The indoor and ending banks only replace the songs of the intro bank.
+  SpcPlayer_Upload(p, kSoundBank_intro);
+  if (StringEqualsNoCase(bank, "indoor"))
+    SpcPlayer_Upload(p, kSoundBank_indoor);
+  else if (StringEqualsNoCase(bank, "ending"))
+    SpcPlayer_Upload(p, kSoundBank_ending);
+  else if (!StringEqualsNoCase(bank, "intro"))
+    PrintUsage();
+
+  FILE *f = NULL;
+  if (output) {
+    f = fopen(output, "wb");
+    if (!f)
+      Die("Unable to create the output file");
+  }
+
+  // Same amount of samples per snes frame as the game uses
+  int samples_per_frame = 534 * freq / 32000;
+  int num_frames = seconds * 60;
+  uint32 num_samples = samples_per_frame * num_frames;
+  int16 *buf = (int16 *)malloc(samples_per_frame * 2 * sizeof(int16));
+  if (f) {
+    uint8 hdr[kWavHeaderSize];
+    MakeWavHeader(hdr, freq, 2, num_samples);
+    fwrite(hdr, 1, sizeof(hdr), f);
+  }
+
+  uint32 hash = 2166136261u;
+  clock_t start = clock();
+  for (int frame = 0; frame < num_frames; frame++) {
+    // The music port holds its value, while the game clears the sound effect
+    // ports again after one frame.
+    memcpy(p->input_ports, ports, 4);
+    if (frame == 0) {
+      for (int i = 1; i < 4; i++)
+        p->input_ports[i] = sfx_ports[i];
+    }
+    SpcPlayer_GenerateSamples(p);
+    dsp_getSamples(p->dsp, buf, samples_per_frame, 2);
+    const uint8 *b = (const uint8 *)buf;
+    for (size_t i = 0; i < samples_per_frame * 2 * sizeof(int16); i++)
+      hash = (hash ^ b[i]) * 16777619u;
+    if (f)
+      fwrite(buf, sizeof(int16), samples_per_frame * 2, f);
+  }
+  double secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+  if (f)
+    fclose(f);
+
+  printf("Rendered %u samples in %.3f s, %.0f samples/s, %.1fx realtime\n",
+         num_samples, secs, num_samples / (secs > 0 ? secs : 1e-9),
+         num_frames / 60.0 / (secs > 0 ? secs : 1e-9));
+  printf("hash %.8x\n", hash);
+  if (have_expected_hash && hash != expected_hash) {
+    fprintf(stderr, "Output hash mismatch, expected %.8x\n", expected_hash);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,205 @@
+// Checks Do3To4High, Do3To4Low, Expand3To4High and the 16-bit variants in
+// src/gfx_3to4.c against the original per word loops, on every 3bpp sheet in
+// zelda3_assets.dat. Both the converted tiles and the leftovers in ram have
+// to match, whichever of the SSE2, NEON or plain paths gfx_3to4.c was built
+// with.
+//
+//   make gfx_3to4_check
+//   ./gfx_3to4_check
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "src/types.h"
+#include "src/util.h"
+#include "src/assets.h"
+#include "src/zelda_rtl.h"
+#include "src/variables.h"
+#include "src/load_gfx.h"
+#include "tool_common.h"
+
+// gfx_3to4.c needs only these from the rest of the game.
+ZeldaEnv g_zenv;
+uint8 g_ram[131072];
+void VramJournal_Mark(uint32 addr, uint32 num) {}
+
+// Loads a 3bpp sheet the way Decomp_spr and Decomp_bg do. Sprite sheets below
+// 103 that are exactly 0x600 bytes are stored uncompressed, and pre-expanded
+// assets keep the 3bpp sheet in front of the expanded one.
+static void LoadSheet(uint8 *dst, MemBlk blk, bool sprite, int i) {
+  if (g_asset_flags & kAssetsFlag_PreExpandedGfx)
+    memcpy(dst, blk.ptr, blk.size == 0x600 + 0x800 * 2 ? 0x600 : blk.size);
+  else if (sprite && i < 103 && blk.size == 0x600)
+    memcpy(dst, blk.ptr, 0x600);
+  else
+    DecompressLz(dst, blk, false);
+}
+
+// The routines as they were before they shared Convert3To4Tile, for reference.
+static void RefDo3To4High(uint16 *vram_ptr, const uint8 *decomp_addr) {
+  for (int j = 0; j < 64; j++) {
+    uint16 *t = (uint16 *)&dung_line_ptrs_row0;
+    for (int i = 7; i >= 0; i--, decomp_addr += 2) {
+      uint16 d = *(uint16 *)decomp_addr;
+      t[i] = (d | (d >> 8)) & 0xff;
+      *vram_ptr++ = d;
+    }
+    for (int i = 7; i >= 0; i--, decomp_addr += 1) {
+      uint8 d = *decomp_addr;
+      *vram_ptr++ = d | (t[i] | d) << 8;
+    }
+  }
+}
+
+static void RefDo3To4Low(uint16 *vram_ptr, const uint8 *decomp_addr) {
+  for (int j = 0; j < 64; j++) {
+    for (int i = 0; i < 8; i++, decomp_addr += 2)
+      *vram_ptr++ = *(uint16 *)decomp_addr;
+    for (int i = 0; i < 8; i++, decomp_addr += 1)
+      *vram_ptr++ = *decomp_addr;
+  }
+}
+
+static void RefExpand3To4High(uint8 *dst, const uint8 *src, const uint8 *base, int num) {
+  do {
+    const uint8 *src2 = src + 0x10;
+    int n = 8;
+    do {
+      uint16 t = WORD(src[0]);
+      uint8 u = src2[0];
+      WORD(dst[0]) = t;
+      WORD(dst[0x10]) = (t | (t >> 8) | u) << 8 | u;
+      src += 2, src2 += 1, dst += 2;
+    } while (--n);
+    dst += 16, src = src2;
+    if (!(src - base & 0x78))
+      src += 0x180;
+  } while (--num);
+}
+
+static void RefDo3To4High16Bit(uint8 *dst, const uint8 *src, int num) {
+  do {
+    const uint8 *src2 = src + 0x10;
+    int n = 8;
+    do {
+      uint16 t = WORD(src[0]);
+      uint8 u = src2[0];
+      WORD(dst[0]) = t;
+      WORD(dst[0x10]) = (t | (t >> 8) | u) << 8 | u;
+      src += 2, src2 += 1, dst += 2;
+    } while (--n);
+    dst += 16, src = src2;
+  } while (--num);
+}
+
+static void RefDo3To4Low16Bit(uint8 *dst, const uint8 *src, int num) {
+  do {
+    const uint8 *src2 = src + 0x10;
+    int n = 8;
+    do {
+      WORD(dst[0]) = WORD(src[0]);
+      WORD(dst[0x10]) = src2[0];
+      src += 2, src2 += 1, dst += 2;
+    } while (--n);
+    dst += 16, src = src2;
+  } while (--num);
+}
+
+typedef void Do3To4Func(uint16 *vram_ptr, const uint8 *decomp_addr);
+typedef void Do3To4BytesFunc(uint8 *dst, const uint8 *src, int num);
+
+enum {
+  kSheetAddr = 0x14000,  // where the game decompresses sheets to
+  kOutAddr = 0x10000,
+};
+
+static uint8 g_saved_ram[131072], g_new_ram[131072];
+static int g_num_checks, g_num_failed;
+
+// Called after the new routine has run on g_ram. Keeps its result, runs the
+// reference from the same starting ram and compares all of ram, so both the
+// converted tiles and anything left behind in WRAM have to match.
+static void SaveNewResult(void) {
+  memcpy(g_new_ram, g_ram, sizeof(g_ram));
+  memcpy(g_ram, g_saved_ram, sizeof(g_ram));
+}
+
+static void CompareWithReference(const char *name, const char *sheet, int num) {
+  g_num_checks++;
+  if (memcmp(g_ram, g_new_ram, sizeof(g_ram)) == 0)
+    return;
+  size_t i = 0;
+  while (g_ram[i] == g_new_ram[i])
+    i++;
+  fprintf(stderr, "%s mismatch on %s, num %d, at ram 0x%zx: %.2x != %.2x\n",
+          name, sheet, num, i, g_new_ram[i], g_ram[i]);
+  g_num_failed++;
+}
+
+static void CheckDo3To4(const char *name, Do3To4Func *func, Do3To4Func *ref, const char *sheet) {
+  memcpy(g_saved_ram, g_ram, sizeof(g_ram));
+  func((uint16 *)&g_ram[kOutAddr], &g_ram[kSheetAddr]);
+  SaveNewResult();
+  ref((uint16 *)&g_ram[kOutAddr], &g_ram[kSheetAddr]);
+  CompareWithReference(name, sheet, 64);
+}
+
+static void CheckDo3To4Bytes(const char *name, Do3To4BytesFunc *func, Do3To4BytesFunc *ref, const char *sheet, int num) {
+  memcpy(g_saved_ram, g_ram, sizeof(g_ram));
+  func(&g_ram[kOutAddr], &g_ram[kSheetAddr], num);
+  SaveNewResult();
+  ref(&g_ram[kOutAddr], &g_ram[kSheetAddr], num);
+  CompareWithReference(name, sheet, num);
+}
+
+// Same tile counts and source offsets as the callers in load_gfx.c
+static void CheckExpand3To4High(const char *sheet, int num) {
+  for (int half = 0; half < 2; half++) {
+    memcpy(g_saved_ram, g_ram, sizeof(g_ram));
+    Expand3To4High(&g_ram[kOutAddr], &g_ram[kSheetAddr + half * 0x180], g_ram, num);
+    SaveNewResult();
+    RefExpand3To4High(&g_ram[kOutAddr], &g_ram[kSheetAddr + half * 0x180], g_ram, num);
+    CompareWithReference(half ? "Expand3To4High+0x180" : "Expand3To4High", sheet, num);
+  }
+}
+
+static void CheckSheet(const char *sheet) {
+  static const int kExpandCounts[] = { 2, 3, 6, 8, 12 };
+  CheckDo3To4("Do3To4High", &Do3To4High, &RefDo3To4High, sheet);
+  CheckDo3To4("Do3To4Low", &Do3To4Low, &RefDo3To4Low, sheet);
+  CheckDo3To4Bytes("Do3To4High16Bit", &Do3To4High16Bit, &RefDo3To4High16Bit, sheet, 64);
+  CheckDo3To4Bytes("Do3To4Low16Bit", &Do3To4Low16Bit, &RefDo3To4Low16Bit, sheet, 64);
+  for (int i = 0; i < countof(kExpandCounts); i++)
+    CheckExpand3To4High(sheet, kExpandCounts[i]);
+}
+
+int main(int argc, char **argv) {
+  const char *assets_file = "zelda3_assets.dat";
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+      assets_file = argv[++i];
+    else {
+      fprintf(stderr, "usage: gfx_3to4_check [-a assets file]\n");
+      return 1;
+    }
+  }
+  LoadAssets(assets_file);
+
+  // Fill ram with something other than zeros so stray writes show up
+  for (size_t i = 0; i < sizeof(g_ram); i++)
+    g_ram[i] = (uint8)(i * 0x9d + (i >> 8));
+
+  char name[32];
+  int num_sheets = 0;
+  for (int i = 12; kSprGfx(i).ptr; i++, num_sheets++) {
+    LoadSheet(&g_ram[kSheetAddr], kSprGfx(i), true, i);
+    snprintf(name, sizeof(name), "sprite sheet %d", i);
+    CheckSheet(name);
+  }
+  for (int i = 0; kBgGfx(i).ptr; i++, num_sheets++) {
+    LoadSheet(&g_ram[kSheetAddr], kBgGfx(i), false, i);
+    snprintf(name, sizeof(name), "bg sheet %d", i);
+    CheckSheet(name);
+  }
+  printf("%d sheets, %d checks, %d failed\n", num_sheets, g_num_checks, g_num_failed);
+  return g_num_failed != 0;
+}
@@ -0,0 +1,144 @@
+// Benchmarks DecompressLz against the original byte by byte decoder over all
+// compressed graphics sheets and overworld maps in zelda3_assets.dat, and
+// checks that both produce the same output.
+//
+//   make lz_bench
+//   ./lz_bench -n 500
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "src/types.h"
+#include "src/util.h"
+#include "src/assets.h"
+#include "tool_common.h"
+
+// The decoder as it was before DecompressLz, for reference.
+static int DecompressReference(uint8 *dst, const uint8 *src, bool big_endian_offs) {
+  uint8 *dst_org = dst;
+  int len;
+  for (;;) {
+    uint8 cmd = *src++;
+    if (cmd == 0xff)
+      return dst - dst_org;
+    if ((cmd & 0xe0) != 0xe0) {
+      len = (cmd & 0x1f) + 1;
+      cmd &= 0xe0;
+    } else {
+      len = *src++;
+      len += ((cmd & 3) << 8) + 1;
+      cmd = (cmd << 3) & 0xe0;
+    }
+    if (cmd == 0) {
+      do {
+        *dst++ = *src++;
+      } while (--len);
+    } else if (cmd & 0x80) {
+      uint32 offs = big_endian_offs ? src[0] << 8 | src[1] : src[0] | src[1] << 8;
+      src += 2;
+      do {
+        *dst++ = dst_org[offs++];
+      } while (--len);
+    } else if (!(cmd & 0x40)) {
+      uint8 v = *src++;
+      do {
+        *dst++ = v;
+      } while (--len);
+    } else if (!(cmd & 0x20)) {
+      uint8 lo = *src++;
+      uint8 hi = *src++;
+      do {
+        *dst++ = lo;
+        if (--len == 0)
+          break;
+        *dst++ = hi;
+      } while (--len);
+    } else {
+      uint8 v = *src++;
+      do {
+        *dst++ = v;
+      } while (v++, --len);
+    }
+  }
+}
+
+typedef struct Stream {
+  MemBlk data;
+  bool big_endian_offs;
+} Stream;
+
+static Stream g_streams[512];
+static int g_num_streams;
+
+static void AddStream(MemBlk data, bool big_endian_offs) {
+  if (data.ptr && data.size && g_num_streams < 512)
+    g_streams[g_num_streams++] = (Stream) { data, big_endian_offs };
+}
+
+static double RunAll(bool reference, uint8 *out, int iterations, size_t *bytes) {
+  clock_t start = clock();
+  size_t total = 0;
+  for (int it = 0; it < iterations; it++) {
+    for (int i = 0; i < g_num_streams; i++) {
+      Stream *s = &g_streams[i];
+      total += reference ? DecompressReference(out, s->data.ptr, s->big_endian_offs) :
+                           DecompressLz(out, s->data, s->big_endian_offs);
+    }
+  }
+  *bytes = total;
+  return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv) {
+  const char *assets_file = "zelda3_assets.dat";
+  int iterations = 200;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+      assets_file = argv[++i];
+    else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+      iterations = atoi(argv[++i]);
+    else {
+      fprintf(stderr, "usage: lz_bench [-a assets file] [-n iterations]\n");
+      return 1;
+    }
+  }
+  LoadAssets(assets_file);
+  if (g_asset_flags & kAssetsFlag_PreExpandedGfx)
+    Die("The graphics in this assets file aren't compressed");
+
+  // Sprite sheets below 103 that are exactly 0x600 bytes are stored uncompressed
+  for (int i = 12; i < 108; i++) {
+    MemBlk b = kSprGfx(i);
+    if (i >= 103 || b.size != 0x600)
+      AddStream(b, false);
+  }
+  for (int i = 0; kBgGfx(i).ptr; i++)
+    AddStream(kBgGfx(i), false);
+  for (int i = 0; kOverworld_Hibytes_Comp(i).ptr; i++) {
+    AddStream(kOverworld_Hibytes_Comp(i), true);
+    AddStream(kOverworld_Lobytes_Comp(i), true);
+  }
+
+  // Back references may point past what's been written so far, so start
+  // from the same buffer contents for the comparison.
+  static uint8 a[0x10000], b[0x10000];
+  for (int i = 0; i < g_num_streams; i++) {
+    Stream *s = &g_streams[i];
+    memset(a, 0xcc, sizeof(a));
+    memset(b, 0xcc, sizeof(b));
+    int lb = DecompressLz(b, s->data, s->big_endian_offs);
+    int la = DecompressReference(a, s->data.ptr, s->big_endian_offs);
+    if (la != lb || memcmp(a, b, sizeof(a)) != 0) {
+      fprintf(stderr, "Output mismatch in stream %d\n", i);
+      return 1;
+    }
+  }
+
+  size_t bytes;
+  double t_ref = RunAll(true, a, iterations, &bytes);
+  double t_new = RunAll(false, b, iterations, &bytes);
+  printf("%d streams, %zu bytes decompressed per run\n", g_num_streams, bytes / (iterations ? iterations : 1));
+  printf("reference:    %8.1f MB/s\n", bytes / 1e6 / (t_ref > 0 ? t_ref : 1e-9));
+  printf("DecompressLz: %8.1f MB/s\n", bytes / 1e6 / (t_new > 0 ? t_new : 1e-9));
+  return 0;
+}
@@ -0,0 +1,182 @@
+// Checks BuildMap8Stripe in src/map8_stripe.h against the per tile loops that
+// BufferAndBuildMap16Stripes_X, BufferAndBuildMap16Stripes_Y and
+// OverworldCopyMap16ToBuffer had before it. Every overworld screen in
+// zelda3_assets.dat is decoded to map16 tiles, and each of its rows and
+// columns is converted from every wrapped starting position, the way the
+// scrolling code feeds them in.
+//
+//   make map8_stripe_check
+//   ./map8_stripe_check
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "src/types.h"
+#include "src/util.h"
+#include "src/assets.h"
+#include "src/map8_stripe.h"
+#include "tool_common.h"
+
+// Same as Overworld_ParseMap32Definition, for the quadrant |part| of a map32 tile.
+static uint16 Map32ToMap16(uint16 m, int part) {
+  const uint8 *tabs[4] = { kMap32ToMap16_0, kMap32ToMap16_1, kMap32ToMap16_2, kMap32ToMap16_3 };
+  const uint8 *ov = tabs[part] + (m >> 2) * 6;
+  int r = m & 3;
+  uint8 hi = ov[4 + (r >> 1)];
+  return ov[r] | ((r & 1) ? hi & 0xf : hi >> 4) << 8;
+}
+
+// Decodes a screen to its 32x32 map16 tiles, like Overworld_DecompressAndDrawOneQuadrant.
+static void DecodeScreen(uint16 map16[32][32], int screen) {
+  static uint8 hi[0x10000], lo[0x10000];
+  DecompressLz(hi, kOverworld_Hibytes_Comp(screen), true);
+  DecompressLz(lo, kOverworld_Lobytes_Comp(screen), true);
+  for (int y = 0; y < 16; y++) {
+    for (int x = 0; x < 16; x++) {
+      uint16 m = lo[y * 16 + x] | hi[y * 16 + x] << 8;
+      map16[y * 2 + 0][x * 2 + 0] = Map32ToMap16(m, 0);
+      map16[y * 2 + 0][x * 2 + 1] = Map32ToMap16(m, 1);
+      map16[y * 2 + 1][x * 2 + 0] = Map32ToMap16(m, 2);
+      map16[y * 2 + 1][x * 2 + 1] = Map32ToMap16(m, 3);
+    }
+  }
+}
+
+// The loops as they were before BuildMap8Stripe, for reference.
+static void RefStripesX(uint16 *dst, const uint16 *map8, const uint16 *tmp) {
+  for (int i = 0; i < 2; i++) {
+    dst++;
+    for (int j = 0; j < 16; j++) {
+      const uint16 *s = map8 + *tmp++ * 4;
+      dst[0] = s[0];
+      dst[33] = s[1];
+      dst[1] = s[2];
+      dst[34] = s[3];
+      dst += 2;
+    }
+    dst += 33;
+  }
+}
+
+static void RefStripesY(uint16 *dst, const uint16 *map8, const uint16 *tmp) {
+  for (int i = 0; i < 2; i++) {
+    dst++;
+    for (int j = 0; j < 16; j++) {
+      const uint16 *s = map8 + *tmp++ * 4;
+      dst[0] = s[0];
+      dst[32] = s[2];
+      dst[1] = s[1];
+      dst[33] = s[3];
+      dst += 2;
+    }
+    dst += 32;
+  }
+}
+
+static void RefCopyMap16ToBuffer(uint16 *dst, const uint16 *map8, const uint16 *tmp) {
+  uint8 *attr = (uint8 *)dst;
+  int r14 = 0;
+  for (int i = 0; i < 2; i++, r14 += 0x40) {
+    for (int j = 0; j < 16; j++, r14 += 4) {
+      const uint16 *m = map8 + 4 * *tmp++;
+      WORD(attr[r14]) = WORD(m[0]);
+      WORD(attr[r14 + 64]) = WORD(m[2]);
+      WORD(attr[r14 + 2]) = WORD(m[1]);
+      WORD(attr[r14 + 66]) = WORD(m[3]);
+    }
+  }
+}
+
+// The new code, called the way overworld.c calls it.
+static void StripesX(uint16 *dst, const uint16 *map8, const uint16 *tmp) {
+  for (int i = 0; i < 2; i++, tmp += 16, dst += 66)
+    BuildMap8Stripe(dst + 1, dst + 34, map8, tmp, 16, true);
+}
+
+static void StripesY(uint16 *dst, const uint16 *map8, const uint16 *tmp) {
+  for (int i = 0; i < 2; i++, tmp += 16, dst += 65)
+    BuildMap8Stripe(dst + 1, dst + 33, map8, tmp, 16, false);
+}
+
+static void CopyMap16ToBuffer(uint16 *dst, const uint16 *map8, const uint16 *tmp) {
+  for (int i = 0; i < 2; i++, tmp += 16, dst += 64)
+    BuildMap8Stripe(dst, dst + 32, map8, tmp, 16, false);
+}
+
+typedef void StripeFunc(uint16 *dst, const uint16 *map8, const uint16 *tmp);
+
+typedef struct StripeCheck {
+  const char *name;
+  StripeFunc *func, *ref;
+  bool column;
+} StripeCheck;
+
+static const StripeCheck kStripeChecks[] = {
+  { "BufferAndBuildMap16Stripes_X", &StripesX, &RefStripesX, true },
+  { "BufferAndBuildMap16Stripes_Y", &StripesY, &RefStripesY, false },
+  { "OverworldCopyMap16ToBuffer", &CopyMap16ToBuffer, &RefCopyMap16ToBuffer, false },
+};
+
+static int g_num_checks, g_num_failed;
+
+// Runs one conversion of the 32 tiles in |tmp| both ways and compares the
+// whole output buffer, so words that should be left alone are checked too.
+static void CheckLine(const StripeCheck *c, int screen, int line, int start, const uint16 *map8, const uint16 *tmp) {
+  static uint16 a[256], b[256];
+  for (int i = 0; i < 256; i++)
+    a[i] = b[i] = 0xcc00 + i;
+  c->func(a, map8, tmp);
+  c->ref(b, map8, tmp);
+  g_num_checks++;
+  if (memcmp(a, b, sizeof(a)) != 0) {
+    int i = 0;
+    while (a[i] == b[i])
+      i++;
+    fprintf(stderr, "%s mismatch on screen %d, line %d, start %d, word %d: %.4x != %.4x\n",
+            c->name, screen, line, start, i, a[i], b[i]);
+    g_num_failed++;
+  }
+}
+
+int main(int argc, char **argv) {
+  const char *assets_file = "zelda3_assets.dat";
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+      assets_file = argv[++i];
+    else {
+      fprintf(stderr, "usage: map8_stripe_check [-a assets file]\n");
+      return 1;
+    }
+  }
+  LoadAssets(assets_file);
+
+  const uint16 *map8 = kMap16ToMap8;
+  uint32 num_map16 = kMap16ToMap8_SIZE / 8;
+  static uint16 map16[32][32];
+  uint16 tmp[32];
+  int num_screens = 0;
+  for (int screen = 0; kOverworld_Hibytes_Comp(screen).ptr; screen++, num_screens++) {
+    DecodeScreen(map16, screen);
+    for (int y = 0; y < 32; y++) {
+      for (int x = 0; x < 32; x++) {
+        if (map16[y][x] >= num_map16 || map16[y][x] >= 0xea8) {
+          fprintf(stderr, "Screen %d has map16 tile %d out of range\n", screen, map16[y][x]);
+          return 1;
+        }
+      }
+    }
+    // The scrolling code fills its 32 entry buffer starting at a wrapping
+    // offset, so try every rotation of every row and column.
+    for (int line = 0; line < 32; line++) {
+      for (int start = 0; start < 32; start++) {
+        for (int i = 0; i < countof(kStripeChecks); i++) {
+          const StripeCheck *c = &kStripeChecks[i];
+          for (int k = 0; k < 32; k++)
+            tmp[k] = c->column ? map16[(start + k) & 31][line] : map16[line][(start + k) & 31];
+          CheckLine(c, screen, line, start, map8, tmp);
+        }
+      }
+    }
+  }
+  printf("%d screens, %d checks, %d failed\n", num_screens, g_num_checks, g_num_failed);
+  return g_num_failed != 0;
+}
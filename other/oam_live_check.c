@@ -0,0 +1,151 @@
+// Checks the list of visible oam entries that ppu_evaluateSprites walks
+// against the full scan of all 128 entries it did before. Each frame fills oam
+// with random entries, about a third of them parked at y 0xf0, the way the
+// nmi copies oam_buf in. Some frames also rewrite a few entries through the
+// $2104 port halfway down the screen. Every line is evaluated both ways and the
+// sprite buffers have to match.
+//
+// ppu_evaluateSprites is static, so this includes snes/ppu.c rather than
+// linking with it.
+//
+//   make oam_live_check
+//   ./oam_live_check
+#include "snes/ppu.c"
+
+// The scan as it was before the list of visible entries, for reference.
+static bool RefEvaluateSprites(Ppu* ppu, int line) {
+  // TODO: iterate over oam normally to determine in-range sprites,
+  //   then iterate those in-range sprites in reverse for tile-fetching
+  // TODO: rectangular sprites, wierdness with sprites at -256
+  int index = 0, index_end = index;
+  int spritesLeft = 32 + 1, tilesLeft = 34 + 1;
+  uint8 spriteSizes[2] = { kSpriteSizes[ppu->objSize][0], kSpriteSizes[ppu->objSize][1] };
+  int extra_left_right = ppu->extraLeftRight;
+  if (ppu->renderFlags & kPpuRenderFlags_NoSpriteLimits)
+    spritesLeft = tilesLeft = 1024;
+  int tilesLeftOrg = tilesLeft;
+
+  do {
+    int yy = ppu->oam[index] >> 8;
+    if (yy == 0xf0)
+      continue;  // this works for zelda because sprites are always 8 or 16.
+    // check if the sprite is on this line and get the sprite size
+    int row = (line - yy) & 0xff;
+    int highOam = ppu->oam[0x100 + (index >> 4)] >> (index & 15);
+    int spriteSize = spriteSizes[(highOam >> 1) & 1];
+    if (row >= spriteSize)
+      continue;
+    // in y-range, get the x location, using the high bit as well
+    int x = (ppu->oam[index] & 0xff) + (highOam & 1) * 256;
+    x -= (x >= 256 + extra_left_right) * 512;
+    // if in x-range
+    if (x <= -(spriteSize + extra_left_right))
+      continue;
+    // break if we found 32 sprites already
+    if (--spritesLeft == 0) {
+      break;
+    }
+    // get some data for the sprite and y-flip row if needed
+    int oam1 = ppu->oam[index + 1];
+    int objAdr = (oam1 & 0x100) ? ppu->objTileAdr2 : ppu->objTileAdr1;
+    if (oam1 & 0x8000)
+      row = spriteSize - 1 - row;
+    // fetch all tiles in x-range
+    int paletteBase = 0x80 + 16 * ((oam1 & 0xe00) >> 9);
+    int prio = SPRITE_PRIO_TO_PRIO((oam1 & 0x3000) >> 12, (oam1 & 0x800) == 0);
+    PpuZbufType z = paletteBase + (prio << 8);
+    
+    for (int col = 0; col < spriteSize; col += 8) {
+      if (col + x > -8 - extra_left_right && col + x < 256 + extra_left_right) {
+        // break if we found 34 8*1 slivers already
+        if (--tilesLeft == 0) {
+          return true;
+        }
+        // figure out which tile this uses, looping within 16x16 pages, and get it's data
+        int usedCol = oam1 & 0x4000 ? spriteSize - 1 - col : col;
+        int usedTile = ((((oam1 & 0xff) >> 4) + (row >> 3)) << 4) | (((oam1 & 0xf) + (usedCol >> 3)) & 0xf);
+        uint16 *addr = &ppu->vram[(objAdr + usedTile * 16 + (row & 0x7)) & 0x7fff];
+        uint32 plane = addr[0] | addr[8] << 16;
+        // go over each pixel
+        int px_left = IntMax(-(col + x + kPpuExtraLeftRight), 0);
+        int px_right = IntMin(256 + kPpuExtraLeftRight - (col + x), 8);
+        PpuZbufType *dst = ppu->objBuffer.data + col + x + px_left + kPpuExtraLeftRight;
+        
+        for (int px = px_left; px < px_right; px++, dst++) {
+          int shift = oam1 & 0x4000 ? px : 7 - px;
+          uint32 bits = plane >> shift;
+          int pixel = (bits >> 0) & 1 | (bits >> 7) & 2 | (bits >> 14) & 4 | (bits >> 21) & 8;
+          // draw it in the buffer if there is a pixel here, and the buffer there is still empty
+          if (pixel != 0 && (dst[0] & 0xff) == 0)
+            dst[0] = z + pixel;
+        }
+      }
+    }
+  } while ((index = (index + 2) & 0xff) != index_end);
+  return (tilesLeft != tilesLeftOrg);
+}
+
+enum {
+  kNumFrames = 500,
+  kNumLines = 225,
+};
+
+static int g_num_checks, g_num_failed;
+
+static uint16 RandomOamWord(void) {
+  return rand() % 3 ? rand() : 0xf000 | (rand() & 0xff);
+}
+
+// Writes through the ports like the game's dma would, which marks the list dirty.
+static void WriteOamWord(Ppu *ppu, int adr, uint16 v) {
+  ppu_write(ppu, 0x02, adr & 0xff);
+  ppu_write(ppu, 0x03, adr >> 8);
+  ppu_write(ppu, 0x04, v & 0xff);
+  ppu_write(ppu, 0x04, v >> 8);
+}
+
+static void CheckLine(Ppu *ppu, Ppu *ref, int frame, int line) {
+  for (int i = 0; i < countof(ppu->objBuffer.data); i++)
+    ppu->objBuffer.data[i] = ref->objBuffer.data[i] = 0x0500;
+  bool r0 = ppu_evaluateSprites(ppu, line);
+  bool r1 = RefEvaluateSprites(ref, line);
+  g_num_checks++;
+  if (r0 != r1 || memcmp(ppu->objBuffer.data, ref->objBuffer.data, sizeof(ppu->objBuffer.data)) != 0) {
+    fprintf(stderr, "Mismatch on frame %d, line %d\n", frame, line);
+    g_num_failed++;
+  }
+}
+
+int main(int argc, char **argv) {
+  static uint8 pixels[256 * 4 * 240];
+  Ppu *ppu = ppu_init(), *ref = ppu_init();
+  ppu_reset(ppu);
+  srand(1);
+  for (int i = 0; i < countof(ppu->vram); i++)
+    ppu->vram[i] = rand();
+  for (int frame = 0; frame < kNumFrames; frame++) {
+    for (int i = 0; i < 0x110; i++)
+      ppu->oam[i] = RandomOamWord();
+    ppu->objTileAdr1 = (rand() & 7) << 13;
+    ppu->objTileAdr2 = (rand() & 3) << 12;
+    ppu->extraLeftRight = frame & 1 ? kPpuExtraLeftRight : 0;
+    PpuBeginDrawing(ppu, pixels, 256 * 4, frame & 2 ? kPpuRenderFlags_NoSpriteLimits : 0);
+    *ref = *ppu;
+    int rewrite_line = frame % 3 == 0 ? rand() % kNumLines : -1;
+    for (int line = 0; line < kNumLines; line++) {
+      if (line == rewrite_line) {
+        int adr = rand() % 0x110;
+        for (int i = 0; i < 8; i++) {
+          uint16 v = RandomOamWord();
+          WriteOamWord(ppu, adr + i, v);
+          WriteOamWord(ref, adr + i, v);
+        }
+      }
+      CheckLine(ppu, ref, frame, line);
+    }
+  }
+  printf("%d frames, %d checks, %d failed\n", kNumFrames, g_num_checks, g_num_failed);
+  ppu_free(ppu);
+  ppu_free(ref);
+  return g_num_failed != 0;
+}
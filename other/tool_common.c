@@ -0,0 +1,23 @@
+// Shared by the tools in other/.
+#include <stdio.h>
+#include <stdlib.h>
+#include "src/types.h"
+#include "src/util.h"
+#include "src/assets.h"
+#include "tool_common.h"
+
+void NORETURN Die(const char *error) {
+  fprintf(stderr, "Error: %s\n", error);
+  exit(1);
+}
+
+void LoadAssets(const char *filename) {
+  size_t length = 0;
+  const uint8 *data = MapWholeFile(filename, &length, false);
+  if (!data)
+    data = ReadWholeFile(filename, &length);
+  if (!data)
+    Die("Failed to read the assets file");
+
+  LoadAssetsFromMemory(data, length);
+}
@@ -0,0 +1,8 @@
+#ifndef ZELDA3_OTHER_TOOL_COMMON_H_
+#define ZELDA3_OTHER_TOOL_COMMON_H_
+
+// Loads zelda3_assets.dat or another assets file for the tools in other/,
+// and dies if it can't be read.
+void LoadAssets(const char *filename);
+
+#endif  // ZELDA3_OTHER_TOOL_COMMON_H_
@@ -123,10 +123,24 @@ void dsp_reset(Dsp* dsp) {
   memset(dsp->firBufferR, 0, sizeof(dsp->firBufferR));
   memset(dsp->sampleBuffer, 0, sizeof(dsp->sampleBuffer));
   dsp->sampleOffset = 0;
+  dsp_invalidateEcho(dsp);
 }
 
 void dsp_saveload(Dsp *dsp, SaveLoadFunc *func, void *ctx) {
   func(ctx, &dsp->ram, sizeof(Dsp) - offsetof(Dsp, ram));
+  dsp_invalidateEcho(dsp);
+}
+
+// Call when apu ram was modified behind the dsp's back, the echo ring may
+// no longer be silent. Waits for the rest of the current pass, one full pass
+// and the fir history.
+void dsp_invalidateEcho(Dsp* dsp) {
+  dsp->echoPendingCycles = dsp->echoRemain + dsp->echoDelay + 8;
+}
+
+static inline bool dsp_channelSilent(const DspChannel* c) {
+  // a released voice with a zero envelope stays silent until the next key on
+  return c->adsrState == 4 && c->gain == 0 && !c->keyOn;
 }
 
 void dsp_cycle(Dsp* dsp) {
@@ -158,17 +172,55 @@ void dsp_cycle(Dsp* dsp) {
   dsp->evenCycle = !dsp->evenCycle;
 }
 
+// Runs |count| cycles at once when all voices are silent and the echo ring
+// holds only silence, ending up in the exact same state as |count| calls to
+// dsp_cycle. No registers may be written in between. Returns false, without
+// doing anything, if the dsp isn't idle.
+bool dsp_cycleIdle(Dsp* dsp, int count) {
+  if(dsp->echoPendingCycles != 0) return false;
+  for(int ch = 0; ch < 8; ch++) {
+    if(!dsp_channelSilent(&dsp->channel[ch])) return false;
+  }
+  // voices still step through their samples, this updates ENDX. pitch
+  // modulation is a no-op as all outputs are zero.
+  for(int ch = 0; ch < 8; ch++) {
+    uint32_t counter = dsp->channel[ch].pitchCounter + dsp->channel[ch].pitch * count;
+    for(int i = counter >> 16; i != 0; i--) {
+      dsp_decodeBrr(dsp, ch);
+    }
+    dsp->channel[ch].pitchCounter = counter;
+    dsp->channel[ch].sampleOut = 0;
+    dsp->ram[(ch << 4) | 8] = 0;
+    dsp->ram[(ch << 4) | 9] = 0;
+  }
+  // the echo ring reads and writes back zeros, only the indexes move
+  dsp->firBufferIndex = (dsp->firBufferIndex + count) & 7;
+  if(count < dsp->echoRemain) {
+    dsp->echoBufferIndex += count;
+    dsp->echoRemain -= count;
+  } else {
+    int pos = (count - dsp->echoRemain) % dsp->echoDelay;
+    dsp->echoBufferIndex = pos;
+    dsp->echoRemain = dsp->echoDelay - pos;
+  }
+  if(dsp->noiseRate != 0) {
+    for(int i = 0; i < count; i++) dsp_handleNoise(dsp);
+  }
+  int n = 534 - dsp->sampleOffset;
+  n = count < n ? count : n;
+  memset(&dsp->sampleBuffer[dsp->sampleOffset * 2], 0, n * 2 * sizeof(int16_t));
+  dsp->sampleOffset += n;
+  dsp->evenCycle ^= count & 1;
+  return true;
+}
+
 static void dsp_handleEcho(Dsp* dsp, int* outputL, int* outputR) {
   // get value out of ram
   uint16_t adr = dsp->echoBufferAdr + dsp->echoBufferIndex * 4;
-  dsp->firBufferL[dsp->firBufferIndex] = (
-    dsp->apu_ram[adr] + (dsp->apu_ram[(adr + 1) & 0xffff] << 8)
-  );
-  dsp->firBufferL[dsp->firBufferIndex] >>= 1;
-  dsp->firBufferR[dsp->firBufferIndex] = (
-    dsp->apu_ram[(adr + 2) & 0xffff] + (dsp->apu_ram[(adr + 3) & 0xffff] << 8)
-  );
-  dsp->firBufferR[dsp->firBufferIndex] >>= 1;
+  int16_t bufL = dsp->apu_ram[adr] + (dsp->apu_ram[(adr + 1) & 0xffff] << 8);
+  int16_t bufR = dsp->apu_ram[(adr + 2) & 0xffff] + (dsp->apu_ram[(adr + 3) & 0xffff] << 8);
+  dsp->firBufferL[dsp->firBufferIndex] = bufL >> 1;
+  dsp->firBufferR[dsp->firBufferIndex] = bufR >> 1;
   // calculate FIR-sum
   int sumL = 0, sumR = 0;
   for(int i = 0; i < 8; i++) {
@@ -219,6 +271,12 @@ static void dsp_handleEcho(Dsp* dsp, int* outputL, int* outputR) {
     dsp->echoRemain = dsp->echoDelay;
     dsp->echoBufferIndex = 0;
   }
+  // track when the ring is all zeros again, for dsp_cycleIdle
+  if((bufL | bufR) != 0 || (dsp->echoWrites && (inL | inR) != 0)) {
+    dsp_invalidateEcho(dsp);
+  } else if(dsp->echoPendingCycles != 0) {
+    dsp->echoPendingCycles--;
+  }
 }
 
 static void dsp_cycleChannel(Dsp* dsp, int ch) {
@@ -236,7 +294,9 @@ static void dsp_cycleChannel(Dsp* dsp, int ch) {
   }
   dsp->channel[ch].pitchCounter = newCounter;
   int16_t sample = 0;
-  if(dsp->channel[ch].useNoise) {
+  if(dsp_channelSilent(&dsp->channel[ch])) {
+    // skip the interpolation, the envelope stays at zero
+  } else if(dsp->channel[ch].useNoise) {
     sample = dsp->noiseSample;
   } else {
     sample = dsp_getSample(dsp, ch, dsp->channel[ch].pitchCounter >> 12, (dsp->channel[ch].pitchCounter >> 4) & 0xff);
@@ -610,6 +670,7 @@ void dsp_write(Dsp *dsp, uint8_t adr, uint8_t val) {
   }
   case ESA: {
     dsp->echoBufferAdr = val << 8;
+    dsp_invalidateEcho(dsp);
     break;
   }
   case EDL: {
@@ -617,6 +678,7 @@ void dsp_write(Dsp *dsp, uint8_t adr, uint8_t val) {
         (val & 0xf) * 512; // 2048-byte steps, stereo sample is 4 bytes
     if (dsp->echoDelay == 0)
       dsp->echoDelay = 1;
+    dsp_invalidateEcho(dsp);
     break;
   }
   case FIR0:
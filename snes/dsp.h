@@ -48,6 +48,8 @@ typedef struct DspChannel {
 
 struct Dsp {
   uint8_t *apu_ram;
+  // cycles until the echo ring is known to only hold silence, not saved
+  uint32_t echoPendingCycles;
   // mirror ram
   uint8_t ram[0x80];
   // 8 channels
@@ -92,6 +94,8 @@ Dsp* dsp_init(uint8_t *apu_ram);
 void dsp_free(Dsp* dsp);
 void dsp_reset(Dsp* dsp);
 void dsp_cycle(Dsp* dsp);
+bool dsp_cycleIdle(Dsp* dsp, int count);
+void dsp_invalidateEcho(Dsp* dsp);
 uint8_t dsp_read(Dsp* dsp, uint8_t adr);
 void dsp_write(Dsp* dsp, uint8_t adr, uint8_t val);
 void dsp_getSamples(Dsp* dsp, int16_t* sampleData, int samplesPerFrame, int numChannels);
@@ -58,6 +58,7 @@ void ppu_reset(Ppu* ppu) {
   ppu->cgramSecondWrite = false;
   ppu->cgramBuffer = 0;
   memset(ppu->oam, 0, sizeof(ppu->oam));
+  ppu->oamLiveDirty = true;
   ppu->oamAdr = 0;
   ppu->oamSecondWrite = false;
   ppu->oamBuffer = 0;
@@ -65,6 +66,8 @@ void ppu_reset(Ppu* ppu) {
   ppu->objTileAdr2 = 0x5000;
   ppu->objSize = 0;
   memset(&ppu->objBuffer, 0, sizeof(ppu->objBuffer));
+  // objBuffer only gets cleared after a line that had sprites in it
+  ppu->lineHasSprites = true;
   for(int i = 0; i < 4; i++) {
     ppu->bgLayer[i].hScroll = 0;
     ppu->bgLayer[i].vScroll = 0;
@@ -132,6 +135,8 @@ void PpuBeginDrawing(Ppu *ppu, uint8_t *pixels, size_t pitch, uint32_t render_fl
   ppu->renderFlags = render_flags;
   ppu->renderPitch = (uint)pitch;
   ppu->renderBuffer = pixels;
+  // oam may have been written directly, so rebuild the visible entries once per frame
+  ppu->oamLiveDirty = true;
 
   // Cache the brightness computation
   if (ppu->brightness != ppu->lastBrightnessMult) {
@@ -168,8 +173,9 @@ void ppu_runLine(Ppu *ppu, int line) {
         j = (j + 1 == mod ? 0 : j + 1);
       }
     }
-    // evaluate sprites
-    ClearBackdrop(&ppu->objBuffer);
+    // evaluate sprites. objBuffer is untouched by lines without sprites.
+    if (ppu->lineHasSprites)
+      ClearBackdrop(&ppu->objBuffer);
     ppu->lineHasSprites = !ppu->forcedBlank && ppu_evaluateSprites(ppu, line - 1);
 
     // outside of visible range?
@@ -1236,11 +1242,27 @@ static bool ppu_getWindowState(Ppu* ppu, int layer, int x) {
   return test1 || test2;
 }
 
+static void ppu_updateLiveOam(Ppu *ppu) {
+  int n = 0;
+  for (int index = 0; index < 0x100; index += 2) {
+    int yy = ppu->oam[index] >> 8;
+    if (yy == 0xf0)
+      continue;  // this works for zelda because sprites are always 8 or 16.
+    int highOam = ppu->oam[0x100 + (index >> 4)] >> (index & 15);
+    PpuOamEntry *e = &ppu->oamLive[n++];
+    e->y = yy;
+    e->big = (highOam >> 1) & 1;
+    e->x = (ppu->oam[index] & 0xff) + (highOam & 1) * 256;
+    e->oam1 = ppu->oam[index + 1];
+  }
+  ppu->oamLiveCount = n;
+  ppu->oamLiveDirty = false;
+}
+
 static bool ppu_evaluateSprites(Ppu* ppu, int line) {
   // TODO: iterate over oam normally to determine in-range sprites,
   //   then iterate those in-range sprites in reverse for tile-fetching
   // TODO: rectangular sprites, wierdness with sprites at -256
-  int index = 0, index_end = index;
   int spritesLeft = 32 + 1, tilesLeft = 34 + 1;
   uint8 spriteSizes[2] = { kSpriteSizes[ppu->objSize][0], kSpriteSizes[ppu->objSize][1] };
   int extra_left_right = ppu->extraLeftRight;
@@ -1248,18 +1270,17 @@ static bool ppu_evaluateSprites(Ppu* ppu, int line) {
     spritesLeft = tilesLeft = 1024;
   int tilesLeftOrg = tilesLeft;
 
-  do {
-    int yy = ppu->oam[index] >> 8;
-    if (yy == 0xf0)
-      continue;  // this works for zelda because sprites are always 8 or 16.
+  if (ppu->oamLiveDirty)
+    ppu_updateLiveOam(ppu);
+  const PpuOamEntry *ent = ppu->oamLive, *ent_end = ent + ppu->oamLiveCount;
+  for (; ent != ent_end; ent++) {
     // check if the sprite is on this line and get the sprite size
-    int row = (line - yy) & 0xff;
-    int highOam = ppu->oam[0x100 + (index >> 4)] >> (index & 15);
-    int spriteSize = spriteSizes[(highOam >> 1) & 1];
+    int row = (line - ent->y) & 0xff;
+    int spriteSize = spriteSizes[ent->big];
     if (row >= spriteSize)
       continue;
     // in y-range, get the x location, using the high bit as well
-    int x = (ppu->oam[index] & 0xff) + (highOam & 1) * 256;
+    int x = ent->x;
     x -= (x >= 256 + extra_left_right) * 512;
     // if in x-range
     if (x <= -(spriteSize + extra_left_right))
@@ -1269,7 +1290,7 @@ static bool ppu_evaluateSprites(Ppu* ppu, int line) {
       break;
     }
     // get some data for the sprite and y-flip row if needed
-    int oam1 = ppu->oam[index + 1];
+    int oam1 = ent->oam1;
     int objAdr = (oam1 & 0x100) ? ppu->objTileAdr2 : ppu->objTileAdr1;
     if (oam1 & 0x8000)
       row = spriteSize - 1 - row;
@@ -1304,7 +1325,7 @@ static bool ppu_evaluateSprites(Ppu* ppu, int line) {
         }
       }
     }
-  } while ((index = (index + 2) & 0xff) != index_end);
+  }
   return (tilesLeft != tilesLeftOrg);
 }
 
@@ -1346,8 +1367,10 @@ void ppu_write(Ppu* ppu, uint8_t adr, uint8_t val) {
       if (!ppu->oamSecondWrite) {
         ppu->oamBuffer = val;
       } else {
-        if (ppu->oamAdr < 0x110)
+        if (ppu->oamAdr < 0x110) {
           ppu->oam[ppu->oamAdr++] = (val << 8) | ppu->oamBuffer;
+          ppu->oamLiveDirty = true;
+        }
       }
       ppu->oamSecondWrite = !ppu->oamSecondWrite;
       break;
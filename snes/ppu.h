@@ -29,6 +29,13 @@ enum {
 
 typedef uint16_t PpuZbufType;
 
+// An oam entry that isn't hidden at y 0xf0, decoded for the sprite scan.
+typedef struct PpuOamEntry {
+  uint8_t y, big;
+  uint16_t x;  // 0-511
+  uint16_t oam1;
+} PpuOamEntry;
+
 typedef struct PpuPixelPrioBufs {
   // This holds the prio in the upper 8 bits and the color in the lower 8 bits.
   PpuZbufType data[kPpuXPixels];
@@ -115,6 +122,12 @@ struct Ppu {
   int32_t m7startY;
 
   uint16_t oam[0x110];
+  // The visible entries of oam, in oam order, so that the sprite scan of each
+  // line doesn't go over all 128 entries. Rebuilt on the first line after
+  // oamLiveDirty is set, which code writing to oam directly must do.
+  bool oamLiveDirty;
+  uint8_t oamLiveCount;
+  PpuOamEntry oamLive[128];
   
   // store 31 extra entries to remove the need for clamp
   uint8_t brightnessMult[32 + 31];
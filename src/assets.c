@@ -0,0 +1,103 @@
+#include "assets.h"
+#include "util.h"
+#include <string.h>
+
+const uint8 *g_asset_ptrs[kNumberOfAssets];
+uint32 g_asset_sizes[kNumberOfAssets];
+uint8 g_asset_flags;
+
+// With kAssetsFlag_OnDemand, the header bytes 56-79 are a bitmap of the assets
+// that are stored compressed. Those are a u32 with the uncompressed size,
+// followed by chunks of a u32 with the compressed size and an lz stream that
+// decompresses to at most 64kb, padded to a multiple of 4.
+static MemBlk g_asset_compressed[kNumberOfAssets];
+static uint8 *g_asset_decompressed[kNumberOfAssets];
+
+void LoadAssetsFromMemory(const uint8 *data, size_t length) {
+  static const char kAssetsSig[] = { kAssets_Sig };
+
+  if (length < 16 + 32 + 32 + 8 + kNumberOfAssets * 4 ||
+      memcmp(data, kAssetsSig, 48) != 0 ||
+      *(uint32*)(data + 80) != kNumberOfAssets || data[48] >= 32)
+    Die("Invalid assets file");
+
+  // restool stores log2 of the page size in the first reserved header byte.
+  // Assets of at least a page start on a page boundary so that they line up
+  // with the pages of a mapping of the file. Older files have 0 there.
+  uint32 page_size = data[48] ? 1u << data[48] : 0;
+  g_asset_flags = data[49];
+  uint32 offset = 88 + kNumberOfAssets * 4 + *(uint32 *)(data + 84);
+
+  for (size_t i = 0; i < kNumberOfAssets; i++) {
+    uint32 size = *(uint32 *)(data + 88 + i * 4);
+    uint32 align = page_size && size >= page_size ? page_size : 4;
+    offset = (offset + align - 1) & ~(align - 1);
+    if ((uint64)offset + size > length)
+      Die("Assets file corruption");
+    if ((g_asset_flags & kAssetsFlag_OnDemand) && i < 24 * 8 && (data[56 + (i >> 3)] >> (i & 7) & 1)) {
+      if (size < 4)
+        Die("Assets file corruption");
+      g_asset_compressed[i] = (MemBlk) { data + offset, size };
+      g_asset_sizes[i] = *(uint32 *)(data + offset);
+      g_asset_ptrs[i] = NULL;
+    } else {
+      g_asset_sizes[i] = size;
+      g_asset_ptrs[i] = data + offset;
+    }
+    offset += size;
+  }
+}
+
+const uint8 *LoadOnDemandAsset(int asset) {
+  MemBlk blk = g_asset_compressed[asset];
+  uint32 size = g_asset_sizes[asset];
+  uint8 *dst = malloc(size ? size : 1);
+  if (!dst)
+    Die("malloc failed");
+  const uint8 *p = blk.ptr + 4, *end = blk.ptr + blk.size;
+  uint32 pos = 0;
+  while (pos < size) {
+    uint32 n;
+    if (end - p < 4 || (n = *(uint32 *)p) > (size_t)(end - p - 4))
+      Die("Assets file corruption");
+    pos += DecompressLz(dst + pos, (MemBlk) { p + 4, n }, false);
+    p += 4 + n;
+  }
+  if (pos != size)
+    Die("Assets file corruption");
+  g_asset_decompressed[asset] = dst;
+  g_asset_ptrs[asset] = dst;
+  return dst;
+}
+
+// Frees the assets that were decompressed on demand. They get decompressed
+// again when next used, so no pointers to them may be kept across this.
+void ReclaimOnDemandAssets() {
+  for (int i = 0; i < kNumberOfAssets; i++) {
+    if (g_asset_decompressed[i]) {
+      free(g_asset_decompressed[i]);
+      g_asset_decompressed[i] = NULL;
+      g_asset_ptrs[i] = NULL;
+    }
+  }
+}
+
+// Returns a copy of |blk| if it points into an asset that was decompressed on
+// demand, for blocks that need to stay around.
+MemBlk PinAssetBlk(MemBlk blk) {
+  for (int i = 0; i < kNumberOfAssets; i++) {
+    const uint8 *p = g_asset_decompressed[i];
+    if (p && blk.ptr >= p && blk.ptr < p + g_asset_sizes[i]) {
+      uint8 *copy = malloc(blk.size ? blk.size : 1);
+      if (!copy)
+        Die("malloc failed");
+      memcpy(copy, blk.ptr, blk.size);
+      return (MemBlk) { copy, blk.size };
+    }
+  }
+  return blk;
+}
+
+MemBlk FindInAssetArray(int asset, int idx) {
+  return FindIndexInMemblk((MemBlk) { AssetPtr(asset), g_asset_sizes[asset] }, idx);
+}
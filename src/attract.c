@@ -1020,6 +1020,7 @@ void Attract_BuildBackgrounds() {  // 8cf7e6
 }
 
 void Attract_TriggerBGDMA(uint16 dstv) {  // 8cf879
+  VramJournal_Mark(dstv, 8 * 0x80);
   uint16 *dst = &g_zenv.vram[dstv];
   for (int i = 0; i < 8; i++) {
     memcpy(dst, &g_ram[0x1006], 0x100);
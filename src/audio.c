@@ -7,6 +7,7 @@
 #include "third_party/opus-1.3.1-stripped/opus.h"
 #include "config.h"
 #include "assets.h"
+#include "util.h"
 
 // This needs to hold a lot more things than with just PCM
 typedef struct MsuPlayerResumeInfo {
@@ -26,19 +27,70 @@ enum {
   kMsuState_Playing = 3,
 };
 
-typedef struct MsuPlayer {
+// Loads and stores of the ring indexes that are shared between the decoder and the mixer
+#if defined(__GNUC__) || defined(__clang__)
+#define AtomicLoadAcquire(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define AtomicStoreRelease(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#else
+// MSVC gives volatile accesses acquire/release semantics, tcc only targets x86.
+#define AtomicLoadAcquire(p) (*(volatile uint32 *)(p))
+#define AtomicStoreRelease(p, v) (*(volatile uint32 *)(p) = (v))
+#endif
+
+enum {
+  kMsuRingSlots = 16,  // Each slot holds up to 960 samples, around 320ms in total
+  kMsuSlot_End = 1,
+  kMsuSlot_Error = 2,
+};
+
+typedef struct MsuRingSlot {
+  uint16 size;
+  uint8 flags;
+  MsuPlayerResumeInfo resume_info;  // Position of the first sample in the slot
+  const int16 *data;  // Points into |samples| or straight into a mapped pcm file
+  int16 samples[960 * 2];
+} MsuRingSlot;
+
+typedef struct MsuRequest {
+  uint8 orig_track, actual_track;
+  MsuPlayerResumeInfo resume;
+} MsuRequest;
+
+// Decodes a track into a ring of PCM samples ahead of time. The file and codec
+// state is only touched by the decoder, the mixer just consumes ring slots.
+typedef struct MsuDecoder {
+  // Written by the game thread with the apu lock held
+  MsuRequest req;
+  uint32 req_seq;
+  // Owned by the decoder
+  uint32 cur_seq;
+  MsuRequest cur_req;
   FILE *f;
-  uint32 buffer_size, buffer_pos;
+  const uint8 *map;  // Memory mapped pcm file, used instead of |f| when available
+  size_t map_size;
+  OpusDecoder *opus;
+  bool finished;
+  bool verify_resume;
   uint32 preskip, samples_until_repeat;
   uint32 total_samples_in_file, repeat_position;
   uint32 cur_file_offs;
+  uint16 range_cur, range_repeat;
+  MsuPlayerResumeInfo resume_info;
+  uint64 packet[(2 + 1275) / 8 + 2];
+  // Single producer, single consumer ring
+  uint32 ring_write, ring_read;
+  uint16 slot_pos;  // Mixer position inside of the slot at ring_read
+  MsuRingSlot ring[kMsuRingSlots];
+} MsuDecoder;
+
+typedef struct MsuPlayer {
   MsuPlayerResumeInfo resume_info;
   uint8 enabled;
   uint8 state;
+  uint8 active;  // The decoder that's playing, the other one prefetches
+  bool use_decoder_thread;
   float volume, volume_step, volume_target;
-  uint16 range_cur, range_repeat;
-  OpusDecoder *opus;
-  int16 buffer[960 * 2];
+  MsuDecoder decoders[2];
 } MsuPlayer;
 
 static MsuPlayer g_msu_player;
@@ -157,23 +209,140 @@ void ZeldaPlayMsuAudioTrack(uint8 music_ctrl) {
   ZeldaApuUnlock();
 }
 
-static void MsuPlayer_CloseFile(MsuPlayer *mp) {
-  if (mp->f)
-    fclose(mp->f);
-  opus_decoder_destroy(mp->opus);
-  mp->opus = NULL;
-  mp->f = NULL;
-  if (mp->state != kMsuState_FinishedPlaying)
-    mp->state = kMsuState_Idle;
-  memset(&mp->resume_info, 0, sizeof(mp->resume_info));
+static void MsuDecoder_CloseFile(MsuDecoder *d) {
+  if (d->f)
+    fclose(d->f);
+  UnmapWholeFile(d->map, d->map_size);
+  opus_decoder_destroy(d->opus);
+  d->opus = NULL;
+  d->f = NULL;
+  d->map = NULL;
+}
+
+// Called from the game thread with the apu lock held.
+static void MsuDecoder_Request(MsuDecoder *d, const MsuRequest *req) {
+  d->req = *req;
+  AtomicStoreRelease(&d->req_seq, d->req_seq + 1);
+}
+
+// Switch to the most recent request and drop everything that was decoded
+// for the previous one. Needs the apu lock.
+static void MsuDecoder_SyncRequest(MsuDecoder *d) {
+  d->cur_req = d->req;
+  d->cur_seq = d->req_seq;
+  d->ring_read = d->ring_write;
+  d->slot_pos = 0;
+}
+
+static void MsuDecoder_PushSlot(MsuDecoder *d, uint8 flags) {
+  MsuRingSlot *slot = &d->ring[d->ring_write & (kMsuRingSlots - 1)];
+  slot->size = 0;
+  slot->flags = flags;
+  AtomicStoreRelease(&d->ring_write, d->ring_write + 1);
+}
+
+static void MsuTrackFilename(char *fname, size_t size, int actual_track, uint8 enabled) {
+  snprintf(fname, size, "%s%d.%s", g_config.msu_path ? g_config.msu_path : "", actual_track, enabled & kMsuEnabled_Opuz ? "opuz" : "pcm");
+}
+
+static void MsuDecoder_Open(MsuDecoder *d, uint8 enabled) {
+  MsuDecoder_CloseFile(d);
+  d->finished = true;
+  int actual_track = d->cur_req.actual_track;
+  if (actual_track == 0)
+    return;
+  char fname[256], buf[8];
+  MsuTrackFilename(fname, sizeof(fname), actual_track, enabled);
+  printf("Loading MSU %s\n", fname);
+  // Pcm tracks are mixed straight out of a file mapping when the platform
+  // supports it, otherwise fall back to buffered reads.
+  if (!(enabled & kMsuEnabled_Opuz))
+    d->map = MapWholeFile(fname, &d->map_size, false);
+  if (d->map != NULL) {
+    if (d->map_size < 8)
+      goto READ_ERROR;
+    memcpy(buf, d->map, 8);
+  } else {
+    d->f = fopen(fname, "rb");
+    if (d->f == NULL)
+      goto READ_ERROR;
+    setvbuf(d->f, NULL, _IOFBF, 16384);
+    if (fread(buf, 1, 8, d->f) != 8) READ_ERROR: {
+      fprintf(stderr, "Unable to read MSU file %s\n", fname);
+      MsuDecoder_CloseFile(d);
+      MsuDecoder_PushSlot(d, kMsuSlot_Error);
+      return;
+    }
+  }
+  uint32 file_tag = *(uint32 *)(buf + 0);
+  d->repeat_position = *(uint32 *)(buf + 4);
+  const MsuPlayerResumeInfo *resume = &d->cur_req.resume;
+  d->verify_resume = (resume->actual_track == actual_track && resume->tag == file_tag);
+  if (d->verify_resume) {
+    memcpy(&d->resume_info, resume, sizeof(d->resume_info));
+  } else {
+    memset(&d->resume_info, 0, sizeof(d->resume_info));
+    d->resume_info.orig_track = d->cur_req.orig_track;
+    d->resume_info.actual_track = actual_track;
+    d->resume_info.tag = file_tag;
+    d->resume_info.range_cur = 8;
+  }
+  d->cur_file_offs = d->resume_info.offset;
+  d->samples_until_repeat = d->resume_info.samples_until_repeat;
+  d->range_cur = d->resume_info.range_cur;
+  d->range_repeat = d->resume_info.range_repeat;
+  d->preskip = 0;
+  if (file_tag == (('Z' << 24) | ('U' << 16) | ('P' << 8) | 'O') && d->f != NULL) {
+    d->opus = opus_decoder_create(48000, 2, NULL);
+    if (!d->opus)
+      goto READ_ERROR;
+    if (d->verify_resume)
+      fseek(d->f, d->cur_file_offs, SEEK_SET);
+  } else if (file_tag == (('1' << 24) | ('U' << 16) | ('S' << 8) | 'M')) {
+    // Nothing to verify for pcm
+    d->verify_resume = false;
+    if (d->map != NULL) {
+      d->total_samples_in_file = (d->map_size - 8) / 4;
+    } else {
+      fseek(d->f, 0, SEEK_END);
+      d->total_samples_in_file = (ftell(d->f) - 8) / 4;
+      fseek(d->f, d->cur_file_offs * 4 + 8, SEEK_SET);
+    }
+    if (d->cur_file_offs > d->total_samples_in_file)
+      goto READ_ERROR;
+    d->samples_until_repeat = d->total_samples_in_file - d->cur_file_offs;
+  } else {
+    goto READ_ERROR;
+  }
+  d->finished = false;
+}
+
+// Reads the tag at the start of a track's file. This is done right away on the
+// game thread, so that a track missing from a partial msu pack falls back to
+// the spc at once instead of when the decoder gets to it.
+static bool MsuPlayer_ReadTag(MsuPlayer *mp, int actual_track, uint32 *tag) {
+  char fname[256];
+  uint8 buf[8];
+  MsuTrackFilename(fname, sizeof(fname), actual_track, mp->enabled);
+  FILE *f = fopen(fname, "rb");
+  size_t n = f ? fread(buf, 1, 8, f) : 0;
+  if (f)
+    fclose(f);
+  if (n != 8) {
+    fprintf(stderr, "Unable to read MSU file %s\n", fname);
+    return false;
+  }
+  *tag = *(uint32 *)buf;
+  return true;
 }
 
 static void MsuPlayer_Open(MsuPlayer *mp, int orig_track, bool resume_from_snapshot) {
   MsuPlayerResumeInfo resume;
   int actual_track = RemapMsuDeluxeTrack(mp, orig_track);
+  uint32 file_tag = 0;
 
+  memset(&resume, 0, sizeof(resume));
   if (!resume_from_snapshot) {
-    resume.tag = 0;
     // Attempt to resume MSU playback when exiting back to the overworld.
     if (main_module_index == 9 &&
         actual_track == ((MsuPlayerResumeInfo *)msu_resume_info_alt)->actual_track && g_config.resume_msu) {
@@ -189,23 +358,25 @@ static void MsuPlayer_Open(MsuPlayer *mp, int orig_track, bool resume_from_snaps
   mp->volume_step = kVolumeTransitionStepFloat[3];
 
   mp->state = kMsuState_Idle;
-  MsuPlayer_CloseFile(mp);
+  memset(&mp->resume_info, 0, sizeof(mp->resume_info));
+
+  // Leave a missing track to the spc
+  if (actual_track != 0 && !MsuPlayer_ReadTag(mp, actual_track, &file_tag))
+    actual_track = 0;
+
+  MsuRequest req = { orig_track, actual_track, resume };
+  MsuDecoder *prefetch = &mp->decoders[mp->active ^ 1];
+  if (actual_track != 0 && mp->use_decoder_thread && prefetch->cur_seq == prefetch->req_seq &&
+      prefetch->req.actual_track == actual_track && memcmp(&prefetch->req.resume, &resume, sizeof(resume)) == 0) {
+    // Already decoding this track at the right position in the background.
+    mp->active ^= 1;
+    prefetch = &mp->decoders[mp->active ^ 1];
+  } else {
+    MsuDecoder_Request(&mp->decoders[mp->active], &req);
+  }
   if (actual_track == 0)
     return;
-  char fname[256], buf[8];
-  snprintf(fname, sizeof(fname), "%s%d.%s", g_config.msu_path ? g_config.msu_path : "", actual_track, mp->enabled & kMsuEnabled_Opuz ? "opuz" : "pcm");
-  printf("Loading MSU %s\n", fname);
-  mp->f = fopen(fname, "rb");
-  if (mp->f == NULL)
-    goto READ_ERROR;
-  setvbuf(mp->f, NULL, _IOFBF, 16384);
-  if (fread(buf, 1, 8, mp->f) != 8) READ_ERROR: {
-    fprintf(stderr, "Unable to read MSU file %s\n", fname);
-    MsuPlayer_CloseFile(mp);
-    return;
-  }
-  uint32 file_tag = *(uint32 *)(buf + 0);
-  mp->repeat_position = *(uint32 *)(buf + 4);
+
   mp->state = (resume.actual_track == actual_track && resume.tag == file_tag) ? kMsuState_Resuming : kMsuState_Playing;
   if (mp->state == kMsuState_Resuming) {
     memcpy(&mp->resume_info, &resume, sizeof(mp->resume_info));
@@ -215,26 +386,19 @@ static void MsuPlayer_Open(MsuPlayer *mp, int orig_track, bool resume_from_snaps
     mp->resume_info.tag = file_tag;
     mp->resume_info.range_cur = 8;
   }
-  mp->cur_file_offs = mp->resume_info.offset;
-  mp->samples_until_repeat = mp->resume_info.samples_until_repeat;
-  mp->range_cur = mp->resume_info.range_cur;
-  mp->range_repeat = mp->resume_info.range_repeat;
-  mp->buffer_size = mp->buffer_pos = 0;
-  mp->preskip = 0;
-  if (file_tag == (('Z' << 24) | ('U' << 16) | ('P' << 8) | 'O')) {
-    mp->opus = opus_decoder_create(48000, 2, NULL);
-    if (!mp->opus)
-      goto READ_ERROR;
-    if (mp->state == kMsuState_Resuming)
-      fseek(mp->f, mp->cur_file_offs, SEEK_SET);
-  } else if (file_tag == (('1' << 24) | ('U' << 16) | ('S' << 8) | 'M')) {
-    fseek(mp->f, 0, SEEK_END);
-    mp->total_samples_in_file = (ftell(mp->f) - 8) / 4;
-    mp->samples_until_repeat = mp->total_samples_in_file - mp->cur_file_offs;
-    fseek(mp->f, mp->cur_file_offs * 4 + 8, SEEK_SET);
-  } else {
-    goto READ_ERROR;
+
+  // Prefetch the head of the track we'll resume when going back to the overworld,
+  // so that switching to it won't have to wait for the disk.
+  const MsuPlayerResumeInfo *alt = (MsuPlayerResumeInfo *)msu_resume_info_alt;
+  MsuRequest prefetch_req;
+  memset(&prefetch_req, 0, sizeof(prefetch_req));
+  if (mp->use_decoder_thread && g_config.resume_msu && alt->actual_track != 0 && alt->actual_track != actual_track) {
+    prefetch_req.orig_track = alt->orig_track;
+    prefetch_req.actual_track = alt->actual_track;
+    memcpy(&prefetch_req.resume, alt, sizeof(prefetch_req.resume));
   }
+  if (memcmp(&prefetch->req, &prefetch_req, sizeof(prefetch_req)) != 0)
+    MsuDecoder_Request(prefetch, &prefetch_req);
 }
 
 static void MixToBufferWithVolume(int16 *dst, const int16 *src, size_t n, float volume) {
@@ -281,117 +445,194 @@ static void MixToBuffer(MsuPlayer *mp, int16 *dst, const int16 *src, uint32 n) {
   MixToBufferWithVolume(dst, src, n, mp->volume);
 }
 
-void MsuPlayer_Mix(MsuPlayer *mp, int16 *audio_buffer, int audio_samples) {
+// Read a byte of every page of |p|, so that the page faults of a mapped file
+// are taken here instead of on the audio thread when it mixes the slot.
+static void MsuDecoder_TouchPages(const uint8 *p, size_t size) {
+  volatile uint8 sink = 0;
+  for (size_t i = 0; i < size; i += 4096)
+    sink += p[i];
+  sink += p[size - 1];
+}
+
+// Decode the next packet of the file into |slot|. Returns 0 or the slot flags
+// for the end of the track or an error.
+static uint8 MsuDecoder_Decode(MsuDecoder *d, MsuRingSlot *slot) {
   int r;
 
-  do {
-    if (mp->buffer_size - mp->buffer_pos == 0) {
-      if (mp->opus != NULL) {
-        if (mp->samples_until_repeat == 0) {
-          if (mp->range_cur == 0) FINISHED_PLAYING: {
-            mp->state = kMsuState_FinishedPlaying;
-            MsuPlayer_CloseFile(mp);
-            return;
-          }
-          opus_decoder_ctl(mp->opus, OPUS_RESET_STATE);
-          fseek(mp->f, mp->range_cur, SEEK_SET);
-          uint8 *file_data = (uint8 *)mp->buffer;
-          if (fread(file_data, 1, 10, mp->f) != 10) READ_ERROR: {
-            fprintf(stderr, "MSU read/decode error!\n");
-            zelda_apu_write(APUI00, mp->resume_info.orig_track);
-            MsuPlayer_CloseFile(mp);
-            return;
-          }
-          uint32 file_offs = *(uint32 *)&file_data[0];
-          assert((file_offs & 0xF0000000) == 0);
-          uint32 samples_until_repeat = *(uint32 *)&file_data[4];
-          uint16 preskip = *(uint32 *)&file_data[8];
-          mp->samples_until_repeat = samples_until_repeat;
-          mp->preskip = preskip & 0x3fff;
-          if (preskip & 0x4000)
-            mp->range_repeat = mp->range_cur;
-          mp->range_cur = (preskip & 0x8000) ? mp->range_repeat : mp->range_cur + 10;
-          mp->cur_file_offs = file_offs;
-          mp->resume_info.range_repeat = mp->range_repeat;
-          mp->resume_info.range_cur = mp->range_cur;
-          fseek(mp->f, file_offs, SEEK_SET);
-        }
-        assert(mp->samples_until_repeat != 0);
-        for (;;) {
-          uint8 *file_data = (uint8 *)mp->buffer;
-          *(uint64 *)file_data = 0;
-          if (fread(file_data, 1, 2, mp->f) != 2)
-            goto READ_ERROR;
-          int size = *(uint16 *)file_data & 0x7fff;
-          if (size > 1275)
-            goto READ_ERROR;
-          int n = (*(uint16 *)file_data >> 15);
-          if (fread(&file_data[2], 1, size, mp->f) != size)
-            goto READ_ERROR;
-          // Verify if the snapshot matches the file on disk.
-          uint64 initial_file_data = *(uint64 *)file_data;
-          if (mp->state == kMsuState_Resuming) {
-            mp->state = kMsuState_Playing;
-            if (mp->resume_info.initial_packet_bytes != initial_file_data)
-              goto READ_ERROR;
-          }
-          mp->resume_info.initial_packet_bytes = initial_file_data;
-          mp->resume_info.samples_until_repeat = mp->samples_until_repeat + mp->preskip;
-          mp->resume_info.offset = mp->cur_file_offs;
-          mp->cur_file_offs += 2 + size;
-          file_data[1] = 0xfc;
-          r = opus_decode(mp->opus, &file_data[2 - n], size + n, mp->buffer, 960, 0);
-          if (r <= 0)
-            goto READ_ERROR;
-          if (r > mp->preskip)
-            break;
-          mp->preskip -= r;
-        }
-      } else {
-        if (mp->samples_until_repeat == 0) {
-          if (mp->resume_info.actual_track < sizeof(kMsuTracksWithRepeat) && !kMsuTracksWithRepeat[mp->resume_info.actual_track])
-            goto FINISHED_PLAYING;
-          mp->samples_until_repeat = mp->total_samples_in_file - mp->repeat_position;
-          if (mp->samples_until_repeat == 0)
-            goto READ_ERROR; // impossible to make progress
-          mp->cur_file_offs = mp->repeat_position;
-          fseek(mp->f, mp->cur_file_offs * 4 + 8, SEEK_SET);
-        }
-        r = UintMin(960, mp->samples_until_repeat);
-        if (fread(mp->buffer, 4, r, mp->f) != r)
-          goto READ_ERROR;
-        mp->resume_info.offset = mp->cur_file_offs;
-        mp->cur_file_offs += r;
+  if (d->opus != NULL) {
+    if (d->samples_until_repeat == 0) {
+      if (d->range_cur == 0)
+        return kMsuSlot_End;
+      opus_decoder_ctl(d->opus, OPUS_RESET_STATE);
+      fseek(d->f, d->range_cur, SEEK_SET);
+      uint8 *file_data = (uint8 *)d->packet;
+      if (fread(file_data, 1, 10, d->f) != 10)
+        return kMsuSlot_Error;
+      uint32 file_offs = *(uint32 *)&file_data[0];
+      assert((file_offs & 0xF0000000) == 0);
+      uint32 samples_until_repeat = *(uint32 *)&file_data[4];
+      uint16 preskip = *(uint32 *)&file_data[8];
+      d->samples_until_repeat = samples_until_repeat;
+      d->preskip = preskip & 0x3fff;
+      if (preskip & 0x4000)
+        d->range_repeat = d->range_cur;
+      d->range_cur = (preskip & 0x8000) ? d->range_repeat : d->range_cur + 10;
+      d->cur_file_offs = file_offs;
+      d->resume_info.range_repeat = d->range_repeat;
+      d->resume_info.range_cur = d->range_cur;
+      fseek(d->f, file_offs, SEEK_SET);
+    }
+    assert(d->samples_until_repeat != 0);
+    for (;;) {
+      uint8 *file_data = (uint8 *)d->packet;
+      *(uint64 *)file_data = 0;
+      if (fread(file_data, 1, 2, d->f) != 2)
+        return kMsuSlot_Error;
+      int size = *(uint16 *)file_data & 0x7fff;
+      if (size > 1275)
+        return kMsuSlot_Error;
+      int n = (*(uint16 *)file_data >> 15);
+      if (fread(&file_data[2], 1, size, d->f) != size)
+        return kMsuSlot_Error;
+      // Verify if the snapshot matches the file on disk.
+      uint64 initial_file_data = *(uint64 *)file_data;
+      if (d->verify_resume) {
+        d->verify_resume = false;
+        if (d->resume_info.initial_packet_bytes != initial_file_data)
+          return kMsuSlot_Error;
       }
-      uint32 n = UintMin(r - mp->preskip, mp->samples_until_repeat);
-      mp->samples_until_repeat -= n;
-      mp->buffer_pos = mp->preskip;
-      mp->buffer_size = mp->buffer_pos + n;
-      mp->preskip = 0;
+      d->resume_info.initial_packet_bytes = initial_file_data;
+      d->resume_info.samples_until_repeat = d->samples_until_repeat + d->preskip;
+      d->resume_info.offset = d->cur_file_offs;
+      d->cur_file_offs += 2 + size;
+      file_data[1] = 0xfc;
+      r = opus_decode(d->opus, &file_data[2 - n], size + n, slot->samples, 960, 0);
+      if (r <= 0)
+        return kMsuSlot_Error;
+      if (r > d->preskip)
+        break;
+      d->preskip -= r;
     }
-#if 0
-    if (mp->samples_to_play > 44100 * 5) {
-      mp->buffer_pos = mp->buffer_size;
+    slot->data = slot->samples + d->preskip * 2;
+  } else {
+    if (d->samples_until_repeat == 0) {
+      if (d->resume_info.actual_track < sizeof(kMsuTracksWithRepeat) && !kMsuTracksWithRepeat[d->resume_info.actual_track])
+        return kMsuSlot_End;
+      if (d->repeat_position >= d->total_samples_in_file)
+        return kMsuSlot_Error; // impossible to make progress
+      d->samples_until_repeat = d->total_samples_in_file - d->repeat_position;
+      d->cur_file_offs = d->repeat_position;
+      if (d->map == NULL)
+        fseek(d->f, d->cur_file_offs * 4 + 8, SEEK_SET);
     }
-#endif
-    int nr = IntMin(audio_samples, mp->buffer_size - mp->buffer_pos);
-    int16 *buf = mp->buffer + mp->buffer_pos * 2;
-    mp->buffer_pos += nr;
-
-#if 0
-    static int t;
-    for (int i = 0; i < nr; i++) {
-      buf[i * 2 + 0] = buf[i * 2 + 1] = 5000 * sinf(2 * 3.1415 * t++ / 440);
+    r = UintMin(960, d->samples_until_repeat);
+    if (d->map != NULL) {
+      // Loop points are just pointer arithmetic, nothing is copied.
+      slot->data = (const int16 *)(d->map + 8) + d->cur_file_offs * 2;
+      MsuDecoder_TouchPages((const uint8 *)slot->data, r * 4);
+    } else {
+      if (fread(slot->samples, 4, r, d->f) != r)
+        return kMsuSlot_Error;
+      slot->data = slot->samples;
     }
-#endif
-    MixToBuffer(mp, audio_buffer, buf, nr);
+    d->resume_info.offset = d->cur_file_offs;
+    d->cur_file_offs += r;
+  }
+  uint32 n = UintMin(r - d->preskip, d->samples_until_repeat);
+  d->samples_until_repeat -= n;
+  d->preskip = 0;
+  slot->size = n;
+  slot->flags = 0;
+  memcpy(&slot->resume_info, &d->resume_info, sizeof(slot->resume_info));
+  return 0;
+}
 
-#if 0
-    static FILE *f;
-    if (!f)f = fopen("out.pcm", "wb");
-    fwrite(audio_buffer, 4, nr, f);
-    fflush(f);
-#endif
+// Fill one more slot of the ring. Returns false if there was nothing to do.
+static bool MsuDecoder_DecodeOne(MsuDecoder *d) {
+  if (d->finished || (d->f == NULL && d->map == NULL) ||
+      d->ring_write - AtomicLoadAcquire(&d->ring_read) >= kMsuRingSlots)
+    return false;
+  MsuRingSlot *slot = &d->ring[d->ring_write & (kMsuRingSlots - 1)];
+  uint8 flags = MsuDecoder_Decode(d, slot);
+  if (flags != 0) {
+    if (flags & kMsuSlot_Error)
+      fprintf(stderr, "MSU read/decode error!\n");
+    // The file stays open until the next track since slots that are still
+    // queued may point into the mapping.
+    d->finished = true;
+    MsuDecoder_PushSlot(d, flags);
+    return true;
+  }
+  AtomicStoreRelease(&d->ring_write, d->ring_write + 1);
+  return true;
+}
+
+static bool MsuDecoder_Update(MsuDecoder *d, uint8 enabled, bool have_lock) {
+  if (d->cur_seq != AtomicLoadAcquire(&d->req_seq)) {
+    if (!have_lock)
+      ZeldaApuLock();
+    MsuDecoder_SyncRequest(d);
+    if (!have_lock)
+      ZeldaApuUnlock();
+    // The file is opened without holding the lock
+    MsuDecoder_Open(d, enabled);
+    return true;
+  }
+  return MsuDecoder_DecodeOne(d);
+}
+
+// Called repeatedly from the decoder thread. Does all file access and decoding
+// outside of the apu lock. Returns false when the rings are full.
+bool ZeldaMsuDecodeAhead() {
+  MsuPlayer *mp = &g_msu_player;
+  // Read without the lock, it only decides which decoder to service first.
+  uint8 active = mp->active;
+  return MsuDecoder_Update(&mp->decoders[active], mp->enabled, false) ||
+         MsuDecoder_Update(&mp->decoders[active ^ 1], mp->enabled, false);
+}
+
+void ZeldaMsuSetDecoderThread(bool enabled) {
+  g_msu_player.use_decoder_thread = enabled;
+}
+
+static void MsuPlayer_Stop(MsuPlayer *mp, uint8 state) {
+  static const MsuRequest kNoTrack;
+  MsuDecoder_Request(&mp->decoders[mp->active], &kNoTrack);
+  mp->state = state;
+  memset(&mp->resume_info, 0, sizeof(mp->resume_info));
+}
+
+void MsuPlayer_Mix(MsuPlayer *mp, int16 *audio_buffer, int audio_samples) {
+  MsuDecoder *d = &mp->decoders[mp->active];
+
+  do {
+    uint32 rd = d->ring_read;
+    if (d->cur_seq != d->req_seq || rd == AtomicLoadAcquire(&d->ring_write)) {
+      // Nothing decoded yet. Without a decoder thread, do it inline.
+      if (mp->use_decoder_thread || !MsuDecoder_Update(d, mp->enabled, true))
+        return;
+      continue;
+    }
+    MsuRingSlot *slot = &d->ring[rd & (kMsuRingSlots - 1)];
+    if (d->slot_pos == 0) {
+      if (slot->flags & kMsuSlot_Error) {
+        zelda_apu_write(APUI00, mp->resume_info.orig_track);
+        MsuPlayer_Stop(mp, kMsuState_Idle);
+        return;
+      } else if (slot->flags & kMsuSlot_End) {
+        MsuPlayer_Stop(mp, kMsuState_FinishedPlaying);
+        return;
+      }
+      memcpy(&mp->resume_info, &slot->resume_info, sizeof(mp->resume_info));
+      mp->state = kMsuState_Playing;
+    }
+    int nr = IntMin(audio_samples, slot->size - d->slot_pos);
+    MixToBuffer(mp, audio_buffer, slot->data + d->slot_pos * 2, nr);
+    d->slot_pos += nr;
+    if (d->slot_pos == slot->size) {
+      d->slot_pos = 0;
+      AtomicStoreRelease(&d->ring_read, rd + 1);
+    }
     audio_samples -= nr, audio_buffer += nr * 2;
   } while (audio_samples != 0);
 }
@@ -431,6 +672,11 @@ void ZeldaDiscardUnusedAudioFrames() {
   }
 }
 
+// Number of snes frames pushed by the game loop but not yet rendered into audio.
+int ZeldaGetQueuedAudioFrames() {
+  return g_apu_write_count;
+}
+
 static void ZeldaResetApuQueue() {
   g_apu_write_ent_pos = g_apu_total_write = g_apu_write_count = 0;
 }
@@ -452,7 +698,7 @@ void ZeldaRenderAudio(int16 *audio_buffer, int samples, int channels) {
   ZeldaPopApuState();
   SpcPlayer_GenerateSamples(g_zenv.player);
   dsp_getSamples(g_zenv.player->dsp, audio_buffer, samples, channels);
-  if (g_msu_player.f && channels == 2)
+  if (g_msu_player.state >= kMsuState_Resuming && channels == 2)
     MsuPlayer_Mix(&g_msu_player, audio_buffer, samples);
   ZeldaApuUnlock();
 }
@@ -10,9 +10,12 @@ void ZeldaPlayMsuAudioTrack(uint8 track);
 bool ZeldaIsMusicPlaying();
 
 void ZeldaEnableMsu(uint8 enable);
+void ZeldaMsuSetDecoderThread(bool enabled);
+bool ZeldaMsuDecodeAhead();
 
 void ZeldaRenderAudio(int16 *audio_buffer, int samples, int channels);
 void ZeldaDiscardUnusedAudioFrames();
+int ZeldaGetQueuedAudioFrames();
 void ZeldaRestoreMusicAfterLoad_Locked(bool is_reset);
 void ZeldaSaveMusicStateToRam_Locked();
 void ZeldaPushApuState();
@@ -0,0 +1,168 @@
+#include "audio_output.h"
+#include "audio.h"
+#include "config.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint8 *g_audiobuffer, *g_audiobuffer_cur, *g_audiobuffer_end;
+static int g_frames_per_block;
+static int g_audio_freq;
+static uint8 g_audio_channels;
+static bool g_rate_control;
+static float g_drc_avg_queued, g_drc_frac;
+
+enum {
+  // The number of snes frames that dynamic rate control tries to keep queued
+  kDrcTargetQueuedFrames = 2,
+};
+
+void AudioOutput_Init(int freq, int channels, bool rate_control) {
+  g_audio_freq = freq;
+  g_audio_channels = channels;
+  g_rate_control = rate_control;
+  g_frames_per_block = (534 * freq) / 32000;
+  // Leave room for the blocks to grow with dynamic rate control
+  g_audiobuffer = malloc((g_frames_per_block + g_frames_per_block / 128 + 1) * channels * sizeof(int16));
+  if (!g_audiobuffer) Die("malloc failed");
+  g_audiobuffer_cur = g_audiobuffer_end = g_audiobuffer;
+}
+
+void AudioOutput_Destroy() {
+  free(g_audiobuffer);
+  g_audiobuffer = g_audiobuffer_cur = g_audiobuffer_end = NULL;
+}
+
+int AudioOutput_GetFramesPerBlock() {
+  return g_frames_per_block;
+}
+
+// Dynamic rate control. The audio output and the game loop run on separate
+// clocks, so instead of dropping or repeating frames, nudge the resampling ratio
+// by up to 0.5% to keep the queue of snes frames at a steady level.
+static int DynamicRateControl_GetFramesForBlock() {
+  g_drc_avg_queued += (ZeldaGetQueuedAudioFrames() - g_drc_avg_queued) * (1.0f / 32);
+  float err = (g_drc_avg_queued - kDrcTargetQueuedFrames) * (1.0f / kDrcTargetQueuedFrames);
+  err = err < -1.0f ? -1.0f : err > 1.0f ? 1.0f : err;
+  // If the video runs ahead, output fewer samples per snes frame so they get consumed faster.
+  float n = g_frames_per_block * (1.0f - 0.005f * err) + g_drc_frac;
+  int frames = (int)n;
+  g_drc_frac = n - frames;
+  return frames;
+}
+
+// Fills |stream| with |len| bytes of audio, rendering snes frames as needed.
+// Must be called with the apu lock held.
+void AudioOutput_Fill(uint8 *stream, int len, int volume) {
+  while (len != 0) {
+    if (g_audiobuffer_end - g_audiobuffer_cur == 0) {
+      int frames = g_rate_control ? DynamicRateControl_GetFramesForBlock() : g_frames_per_block;
+      ZeldaRenderAudio((int16*)g_audiobuffer, frames, g_audio_channels);
+      g_audiobuffer_cur = g_audiobuffer;
+      g_audiobuffer_end = g_audiobuffer + frames * g_audio_channels * sizeof(int16);
+    }
+    int n = IntMin(len, g_audiobuffer_end - g_audiobuffer_cur);
+    if (volume >= kAudioOutputVolume_Max) {
+      memcpy(stream, g_audiobuffer_cur, n);
+    } else {
+      const int16 *src = (const int16 *)g_audiobuffer_cur;
+      int16 *dst = (int16 *)stream;
+      for (int i = 0; i < n / 2; i++)
+        dst[i] = src[i] * volume / kAudioOutputVolume_Max;
+    }
+    g_audiobuffer_cur += n;
+    stream += n;
+    len -= n;
+  }
+
+  // With dynamic rate control, only drop frames if the drift is bigger than what it can handle.
+  if (!g_rate_control || ZeldaGetQueuedAudioFrames() > kDrcTargetQueuedFrames * 2)
+    ZeldaDiscardUnusedAudioFrames();
+}
+
+// Time from the game writing to the apu until it's heard: snes frames waiting
+// to be rendered, rendered audio not yet handed out, and the output's buffer.
+int AudioOutput_GetLatencyMs(const AudioOutputFuncs *output) {
+  if (!g_audiobuffer)
+    return 0;
+  int frames = ZeldaGetQueuedAudioFrames() * g_frames_per_block +
+               (int)(g_audiobuffer_end - g_audiobuffer_cur) / (g_audio_channels * sizeof(int16)) +
+               output->GetQueuedFrames();
+  return frames * 1000 / g_audio_freq;
+}
+
+// Outputs without a device model a sound card that consumes one block at a time.
+static int g_sink_block_frames;
+
+static bool NullAudioOutput_Open(int *freq, int *channels, int *samples) {
+  g_sink_block_frames = *samples;
+  return true;
+}
+
+static void NullAudioOutput_Close() {
+}
+
+static void NullAudioOutput_SetPaused(bool paused) {
+}
+
+static void NullAudioOutput_Write(const int16 *data, int frames) {
+}
+
+static int NullAudioOutput_GetQueuedFrames() {
+  return g_sink_block_frames;
+}
+
+const AudioOutputFuncs kNullAudioOutput = {
+  &NullAudioOutput_Open,
+  &NullAudioOutput_Close,
+  &NullAudioOutput_SetPaused,
+  &NullAudioOutput_Write,
+  &NullAudioOutput_GetQueuedFrames,
+};
+
+static FILE *g_wav_file;
+static uint32 g_wav_frames;
+static int g_wav_freq, g_wav_channels;
+
+static void WavAudioOutput_WriteHeader() {
+  uint8 hdr[kWavHeaderSize];
+  MakeWavHeader(hdr, g_wav_freq, g_wav_channels, g_wav_frames);
+  fseek(g_wav_file, 0, SEEK_SET);
+  fwrite(hdr, 1, sizeof(hdr), g_wav_file);
+}
+
+static bool WavAudioOutput_Open(int *freq, int *channels, int *samples) {
+  const char *path = g_config.audio_output_path ? g_config.audio_output_path : "zelda3_audio.wav";
+  g_wav_file = fopen(path, "wb");
+  if (!g_wav_file) {
+    fprintf(stderr, "Unable to create %s\n", path);
+    return false;
+  }
+  g_wav_frames = 0;
+  g_wav_freq = *freq;
+  g_wav_channels = *channels;
+  g_sink_block_frames = *samples;
+  // Filled in with the real size when closing
+  WavAudioOutput_WriteHeader();
+  return true;
+}
+
+static void WavAudioOutput_Close() {
+  WavAudioOutput_WriteHeader();
+  fclose(g_wav_file);
+  g_wav_file = NULL;
+}
+
+static void WavAudioOutput_Write(const int16 *data, int frames) {
+  fwrite(data, sizeof(int16) * g_wav_channels, frames, g_wav_file);
+  g_wav_frames += frames;
+}
+
+const AudioOutputFuncs kWavAudioOutput = {
+  &WavAudioOutput_Open,
+  &WavAudioOutput_Close,
+  &NullAudioOutput_SetPaused,
+  &WavAudioOutput_Write,
+  &NullAudioOutput_GetQueuedFrames,
+};
@@ -0,0 +1,33 @@
+#ifndef ZELDA3_AUDIO_OUTPUT_H_
+#define ZELDA3_AUDIO_OUTPUT_H_
+
+#include "types.h"
+
+enum {
+  kAudioOutputVolume_Max = 128,
+};
+
+// An output either pulls audio itself by calling AudioOutput_Fill from its own
+// callback, or gets it pushed through Write, by a producer thread or once per
+// game frame.
+typedef struct AudioOutputFuncs {
+  // |freq|, |channels| and |samples| are updated with what the output ended up using.
+  bool (*Open)(int *freq, int *channels, int *samples);
+  void (*Close)();
+  void (*SetPaused)(bool paused);
+  // NULL for outputs that pull audio themselves.
+  void (*Write)(const int16 *data, int frames);
+  // Frames that were handed to the output but aren't played yet.
+  int (*GetQueuedFrames)();
+} AudioOutputFuncs;
+
+extern const AudioOutputFuncs kNullAudioOutput;
+extern const AudioOutputFuncs kWavAudioOutput;
+
+void AudioOutput_Init(int freq, int channels, bool rate_control);
+void AudioOutput_Destroy();
+int AudioOutput_GetFramesPerBlock();
+void AudioOutput_Fill(uint8 *stream, int len, int volume);
+int AudioOutput_GetLatencyMs(const AudioOutputFuncs *output);
+
+#endif  // ZELDA3_AUDIO_OUTPUT_H_
@@ -387,6 +387,16 @@ static bool HandleIniConfig(int section, const char *key, char *value) {
     } else if (StringEqualsNoCase(key, "AudioSamples")) {
       g_config.audio_samples = (uint16)strtol(value, (char**)NULL, 10);
       return true;
+    } else if (StringEqualsNoCase(key, "AudioOutput")) {
+      g_config.audio_output = StringEqualsNoCase(value, "Null") ? kAudioOutput_Null :
+                              StringEqualsNoCase(value, "Wav") ? kAudioOutput_Wav :
+                                                                 kAudioOutput_SDL;
+      return true;
+    } else if (StringEqualsNoCase(key, "AudioOutputPath")) {
+      g_config.audio_output_path = value;
+      return true;
+    } else if (StringEqualsNoCase(key, "AudioRenderPerFrame")) {
+      return ParseBool(value, &g_config.audio_render_per_frame);
     } else if (StringEqualsNoCase(key, "EnableMSU")) {
         if (StringEqualsNoCase(value, "opuz"))
         g_config.enable_msu = kMsuEnabled_Opuz;
@@ -440,8 +450,16 @@ static bool HandleIniConfig(int section, const char *key, char *value) {
       return true;
     } else if (StringEqualsNoCase(key, "DisplayPerfInTitle")) {
       return ParseBool(value, &g_config.display_perf_title);
+    } else if (StringEqualsNoCase(key, "SpriteProfile")) {
+      g_config.sprite_profile = (uint16)strtol(value, (char**)NULL, 10);
+      return true;
     } else if (StringEqualsNoCase(key, "DisableFrameDelay")) {
       return ParseBool(value, &g_config.disable_frame_delay);
+    } else if (StringEqualsNoCase(key, "AdaptiveFramePacing")) {
+      return ParseBool(value, &g_config.adaptive_frame_pacing);
+    } else if (StringEqualsNoCase(key, "GfxSheetCache")) {
+      g_config.gfx_sheet_cache = (uint16)strtol(value, (char**)NULL, 10);
+      return true;
     } else if (StringEqualsNoCase(key, "Language")) {
       g_config.language = value;
       return true;
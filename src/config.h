@@ -44,6 +44,12 @@ enum {
   kOutputMethod_OpenGL_ES,
 };
 
+enum {
+  kAudioOutput_SDL,
+  kAudioOutput_Null,
+  kAudioOutput_Wav,
+};
+
 typedef struct Config {
   int window_width;
   int window_height;
@@ -58,14 +64,19 @@ typedef struct Config {
   uint16 audio_freq;
   uint8 audio_channels;
   uint16 audio_samples;
+  uint8 audio_output;
+  bool audio_render_per_frame;
   bool autosave;
   uint8 extended_aspect_ratio;
   bool extend_y;
   bool no_sprite_limits;
   bool display_perf_title;
+  uint16 sprite_profile;
   uint8 enable_msu;
   bool resume_msu;
   bool disable_frame_delay;
+  bool adaptive_frame_pacing;
+  uint16 gfx_sheet_cache;
   uint8 msuvolume;
   uint32 features0;
 
@@ -73,6 +84,7 @@ typedef struct Config {
   char *memory_buffer;
   const char *shader;
   const char *msu_path;
+  const char *audio_output_path;
   const char *language;
 } Config;
 
@@ -2541,6 +2541,240 @@ void SavePalaceDeaths() {  // 80f9dd
     death_save_counter = 0;
 }
 
+// Drawing a room's floors and objects depends on the room and on the state
+// that's listed here, and it writes the two tilemaps and more of that state.
+// So rooms are cached by the bytes of these variables before drawing, and
+// revisiting one with the same state copies back what the drawing produced.
+typedef struct RamVar {
+  void *ptr;
+  uint16 size;
+} RamVar;
+#define V(x) { &(x), sizeof(x) }
+static const RamVar kRoomCacheVars[] = {
+  V(main_module_index), V(link_direction_facing), V(CGWSEL_copy), V(CGADSUB_copy), V(dungeon_room_index),
+  V(quadrant_fullsize_y), { dung_hdr_tag, 2 }, V(dung_draw_width_indicator), V(dung_draw_height_indicator),
+  V(dung_load_ptr), V(dung_load_ptr_bank), V(dung_load_ptr_offs), { &dung_line_ptrs_row0, 33 }, V(dung_unk2),
+  V(dung_unk6), V(dung_door_opened), V(dung_savegame_state_bits), V(dung_layout_and_starting_quadrant),
+  V(dung_hdr_bg2_properties), V(dung_floor_move_flags), { dung_some_subpixel, 2 }, V(moving_wall_var2),
+  V(dung_hdr_collision_2_mirror), V(moving_wall_var1), V(dung_misc_objs_index), V(dung_index_of_torches),
+  V(dung_num_star_shaped_switches), V(invisible_door_dir_and_index_x2), V(dung_num_inter_room_upnorth_stairs),
+  V(dung_num_inter_room_southdown_stairs), V(dung_num_inroom_southdown_stairs), V(dung_num_interpseudo_upnorth_stairs),
+  V(dung_num_inroom_upnorth_stairs_water), V(dung_num_activated_water_ladders), V(dung_num_water_ladders),
+  V(dung_some_stairs_unk4), V(dung_num_toggle_floor), V(dung_num_toggle_palace), V(dung_blastwall_flag_y),
+  V(dung_num_lit_torches), V(dung_cur_door_idx), V(dung_flag_trapdoors_down), V(dung_floor_2_filler_tiles),
+  V(dung_hdr_collision), V(watergate_var1), V(watergate_pos), V(dung_index_of_torches_start), V(word_7E047C),
+  V(dung_num_wall_upnorth_spiral_stairs), V(dung_num_wall_downnorth_spiral_stairs),
+  V(dung_num_wall_upnorth_spiral_stairs_2), V(dung_num_wall_downnorth_spiral_stairs_2),
+  V(dung_floor_1_filler_tiles), V(dung_num_chests_x2), V(dung_num_bigkey_locks_x2), V(dung_num_stairs_1),
+  V(dung_num_stairs_2), V(dung_num_stairs_wet), V(dung_num_inter_room_upnorth_straight_stairs),
+  V(dung_num_inter_room_upsouth_straight_stairs), V(dung_num_inter_room_downnorth_straight_stairs),
+  V(dung_num_inter_room_downsouth_straight_stairs), V(dung_num_inroom_upsouth_stairs_water),
+  { dung_replacement_tile_state, 0x20 }, { dung_object_pos_in_objdata, 0x20 }, { dung_object_tilemap_pos, 0x20 },
+  { replacement_tilemap_UL, 0x20 }, { replacement_tilemap_LL, 0x20 }, { replacement_tilemap_UR, 0x20 },
+  { replacement_tilemap_LR, 0x20 }, V(dung_loade_bgoffs_h_copy), V(dung_loade_bgoffs_v_copy),
+  V(water_hdma_var0), V(water_hdma_var1), V(water_hdma_var2), V(water_hdma_var3), V(water_hdma_var4),
+  V(water_hdma_var5), V(dung_door_opened_incl_adjacent), { star_shaped_switches_tile, 0x10 },
+  { dung_inter_starcases, 8 }, { dung_stairs_table_1, 8 }, { dung_toggle_floor_pos, 0x10 },
+  { dung_toggle_palace_pos, 0x10 }, { dung_chest_locations, 0xc }, { dung_stairs_table_2, 0x14 },
+  { door_type_and_slot, 0x20 }, { dung_door_tilemap_address, 0x20 }, { dung_door_direction, 0x20 },
+  V(dung_exit_door_count), { dung_exit_door_addresses, 8 }, { moving_wall_arr1, 0x80 },
+  { movable_block_datas, 0x18c }, { dung_torch_data, 0x120 }, V(savegame_is_darkworld),
+};
+#undef V
+
+// Set to 1 to draw the room again on every cache hit and compare all of ram
+// with what the cache restored. That catches state the drawing reads which
+// isn't in the list above.
+#define ROOM_CACHE_VERIFY 0
+
+enum {
+  kRoomCache_Entries = 16,
+  kRoomCache_TilemapStart = 0x2000,  // dung_bg2 and dung_bg1
+  kRoomCache_TilemapSize = 0x4000,
+};
+
+typedef struct RoomCacheEntry {
+  uint32 last_used;
+  uint16 save_info[2];
+  uint8 *before, *after;
+  uint8 tilemaps[kRoomCache_TilemapSize];
+} RoomCacheEntry;
+
+static RoomCacheEntry *g_room_cache[kRoomCache_Entries];
+static uint32 g_room_cache_clock;
+static int g_room_cache_state_size;
+static uint8 *g_room_cache_before, *g_room_cache_ram;
+
+static void RoomCache_SaveState(uint8 *dst) {
+  for (int i = 0; i < countof(kRoomCacheVars); i++) {
+    memcpy(dst, kRoomCacheVars[i].ptr, kRoomCacheVars[i].size);
+    dst += kRoomCacheVars[i].size;
+  }
+}
+
+static void RoomCache_LoadState(const uint8 *src) {
+  for (int i = 0; i < countof(kRoomCacheVars); i++) {
+    memcpy(kRoomCacheVars[i].ptr, src, kRoomCacheVars[i].size);
+    src += kRoomCacheVars[i].size;
+  }
+}
+
+// Besides the listed state, the objects look at the save data of the room and
+// of room 101.
+static bool RoomCache_Lookup() {
+  if (!g_room_cache_state_size) {
+    for (int i = 0; i < countof(kRoomCacheVars); i++)
+      g_room_cache_state_size += kRoomCacheVars[i].size;
+    g_room_cache_before = malloc(g_room_cache_state_size);
+    g_room_cache_ram = malloc(sizeof(g_ram));
+    if (!g_room_cache_before || !g_room_cache_ram)
+      Die("malloc failed");
+  }
+  RoomCache_SaveState(g_room_cache_before);
+  if (ROOM_CACHE_VERIFY)
+    memcpy(g_room_cache_ram, g_ram, sizeof(g_ram));
+  for (int i = 0; i < kRoomCache_Entries; i++) {
+    RoomCacheEntry *e = g_room_cache[i];
+    if (e && e->save_info[0] == save_dung_info[dungeon_room_index] && e->save_info[1] == save_dung_info[101] &&
+        memcmp(e->before, g_room_cache_before, g_room_cache_state_size) == 0) {
+      e->last_used = ++g_room_cache_clock;
+      RoomCache_LoadState(e->after);
+      memcpy(&g_ram[kRoomCache_TilemapStart], e->tilemaps, kRoomCache_TilemapSize);
+      return true;
+    }
+  }
+  memcpy(g_room_cache_ram, g_ram, sizeof(g_ram));
+  return false;
+}
+
+static bool RoomCache_IsListed(int addr) {
+  if (addr >= kRoomCache_TilemapStart && addr < kRoomCache_TilemapStart + kRoomCache_TilemapSize)
+    return true;
+  for (int i = 0; i < countof(kRoomCacheVars); i++) {
+    int start = (uint8 *)kRoomCacheVars[i].ptr - g_ram;
+    if (addr >= start && addr < start + kRoomCacheVars[i].size)
+      return true;
+  }
+  return false;
+}
+
+// Called after drawing a room that wasn't cached. Rooms whose drawing changed
+// anything outside of what's listed don't get cached.
+static void RoomCache_Store() {
+  for (int i = 0; i < sizeof(g_ram); i++) {
+    if (g_ram[i] != g_room_cache_ram[i] && !RoomCache_IsListed(i))
+      return;
+  }
+  int slot = 0;
+  for (int i = 0; i < kRoomCache_Entries; i++) {
+    if (!g_room_cache[i]) {
+      slot = i;
+      break;
+    }
+    if (g_room_cache[i]->last_used < g_room_cache[slot]->last_used)
+      slot = i;
+  }
+  RoomCacheEntry *e = g_room_cache[slot];
+  if (!e) {
+    e = malloc(sizeof(RoomCacheEntry));
+    uint8 *state = malloc(g_room_cache_state_size * 2);
+    if (!e || !state) {
+      free(e);
+      free(state);
+      return;
+    }
+    e->before = state;
+    e->after = state + g_room_cache_state_size;
+    g_room_cache[slot] = e;
+  }
+  e->last_used = ++g_room_cache_clock;
+  e->save_info[0] = save_dung_info[dungeon_room_index];
+  e->save_info[1] = save_dung_info[101];
+  memcpy(e->before, g_room_cache_before, g_room_cache_state_size);
+  RoomCache_SaveState(e->after);
+  memcpy(e->tilemaps, &g_ram[kRoomCache_TilemapStart], kRoomCache_TilemapSize);
+}
+
+static void Dungeon_DrawRoomObjects() {
+  const uint8 *cur_p0 = GetDungeonRoomLayout(dungeon_room_index);
+  dung_load_ptr_offs = 0;
+  RoomDraw_DrawFloors(cur_p0);
+
+  uint16 old_offs = dung_load_ptr_offs;
+  dung_layout_and_starting_quadrant = cur_p0[dung_load_ptr_offs];
+
+  const uint8 *cur_p1 = GetDefaultRoomLayout(dung_layout_and_starting_quadrant >> 2);
+
+  dung_load_ptr_offs = 0;
+  RoomDraw_DrawAllObjects(cur_p1);
+
+  dung_load_ptr_offs = old_offs + 1;
+
+  RoomDraw_DrawAllObjects(cur_p0);  // Draw Layer 1 objects to BG2
+  dung_load_ptr_offs += 2;
+
+  memcpy(&dung_line_ptrs_row0, kDungeon_DrawObjectOffsets_BG2, 33);
+  RoomDraw_DrawAllObjects(cur_p0);  // Draw Layer 2 objects to BG2
+  dung_load_ptr_offs += 2;
+
+  memcpy(&dung_line_ptrs_row0, kDungeon_DrawObjectOffsets_BG1, 33);
+  RoomDraw_DrawAllObjects(cur_p0);  // Draw Layer 3 objects to BG2
+
+  for (dung_load_ptr_offs = 0; dung_load_ptr_offs != 0x18C; dung_load_ptr_offs += 4) {
+    MovableBlockData m = movable_block_datas[dung_load_ptr_offs >> 2];
+    if (m.room == dungeon_room_index)
+      DrawObjects_PushableBlock(m.tilemap, dung_load_ptr_offs);
+  }
+
+  uint16 t;
+
+  dung_index_of_torches = dung_index_of_torches_start = dung_misc_objs_index;
+  int i = 0;
+  do {
+    if (dung_torch_data[i >> 1] == dungeon_room_index) {
+      i += 2;
+
+      do {
+        t = dung_torch_data[i >> 1];
+        i += 2;
+        DrawObjects_LightableTorch(t, i - 2);
+      } while (dung_torch_data[i >> 1] != 0xffff);
+      break;
+    }
+    i += 2;
+    do {
+      t = dung_torch_data[i >> 1];
+      i += 2;
+    } while (t != 0xffff);
+  } while (i != 0x120);
+
+  dung_load_ptr_offs = 0x120;
+}
+
+// Called after a cache hit with ROOM_CACHE_VERIFY. Draws the room again from
+// the ram as it was before the lookup, and reports where that differs from
+// what the cache restored.
+static void RoomCache_Verify() {
+  uint8 *cached = malloc(sizeof(g_ram));
+  if (!cached)
+    Die("malloc failed");
+  memcpy(cached, g_ram, sizeof(g_ram));
+  memcpy(g_ram, g_room_cache_ram, sizeof(g_ram));
+  Dungeon_DrawRoomObjects();
+  int count = 0, first = -1;
+  for (int i = 0; i < sizeof(g_ram); i++) {
+    if (g_ram[i] != cached[i]) {
+      if (first < 0)
+        first = i;
+      count++;
+    }
+  }
+  if (count)
+    fprintf(stderr, "Room cache mismatch in room %d: %d bytes differ, first at ram 0x%x (%.2x != %.2x)\n",
+            dungeon_room_index, count, first, cached[first], g_ram[first]);
+  free(cached);
+}
+
 void Dungeon_LoadRoom() {  // 81873a
   Dungeon_LoadHeader();
   dung_unk6 = 0;
@@ -2606,59 +2840,12 @@ void Dungeon_LoadRoom() {  // 81873a
     dung_object_tilemap_pos[i] = 0;
   }
 
-  const uint8 *cur_p0 = GetDungeonRoomLayout(dungeon_room_index);
-  dung_load_ptr_offs = 0;
-  RoomDraw_DrawFloors(cur_p0);
-
-  uint16 old_offs = dung_load_ptr_offs;
-  dung_layout_and_starting_quadrant = cur_p0[dung_load_ptr_offs];
-
-  const uint8 *cur_p1 = GetDefaultRoomLayout(dung_layout_and_starting_quadrant >> 2);
-
-  dung_load_ptr_offs = 0;
-  RoomDraw_DrawAllObjects(cur_p1);
-
-  dung_load_ptr_offs = old_offs + 1;
-
-  RoomDraw_DrawAllObjects(cur_p0);  // Draw Layer 1 objects to BG2
-  dung_load_ptr_offs += 2;
-
-  memcpy(&dung_line_ptrs_row0, kDungeon_DrawObjectOffsets_BG2, 33);
-  RoomDraw_DrawAllObjects(cur_p0);  // Draw Layer 2 objects to BG2
-  dung_load_ptr_offs += 2;
-
-  memcpy(&dung_line_ptrs_row0, kDungeon_DrawObjectOffsets_BG1, 33);
-  RoomDraw_DrawAllObjects(cur_p0);  // Draw Layer 3 objects to BG2
-
-  for (dung_load_ptr_offs = 0; dung_load_ptr_offs != 0x18C; dung_load_ptr_offs += 4) {
-    MovableBlockData m = movable_block_datas[dung_load_ptr_offs >> 2];
-    if (m.room == dungeon_room_index)
-      DrawObjects_PushableBlock(m.tilemap, dung_load_ptr_offs);
+  if (!RoomCache_Lookup()) {
+    Dungeon_DrawRoomObjects();
+    RoomCache_Store();
+  } else if (ROOM_CACHE_VERIFY) {
+    RoomCache_Verify();
   }
-
-  uint16 t;
-
-  dung_index_of_torches = dung_index_of_torches_start = dung_misc_objs_index;
-  int i = 0;
-  do {
-    if (dung_torch_data[i >> 1] == dungeon_room_index) {
-      i += 2;
-
-      do {
-        t = dung_torch_data[i >> 1];
-        i += 2;
-        DrawObjects_LightableTorch(t, i - 2);
-      } while (dung_torch_data[i >> 1] != 0xffff);
-      break;
-    }
-    i += 2;
-    do {
-      t = dung_torch_data[i >> 1];
-      i += 2;
-    } while (t != 0xffff);
-  } while (i != 0x120);
-
-  dung_load_ptr_offs = 0x120;
 }
 
 void RoomDraw_DrawAllObjects(const uint8 *level_data) {  // 8188e4
@@ -2727,33 +2914,27 @@ void RoomDraw_DrawFloors(const uint8 *level_data) {  // 8189dc
   RoomDraw_FloorChunks(SrcPtr(dung_floor_2_filler_tiles));
 }
 
-void RoomDraw_FloorChunks(const uint16 *src) {  // 818a1f
-  static const uint16 kDungeon_QuadrantOffsets[] = { 0x0, 0x40, 0x1000, 0x1040 };
-  for (int i = 0; i < 4; i++) {
-    uint16 *dst = DstoPtr(kDungeon_QuadrantOffsets[i] / 2);
-    for (int j = 0; j < 8; j++) {
-      RoomDraw_A_Many32x32Blocks(8, src, dst);
-      dst += XY(0, 4);
-    }
+// Draws |w| by |h| blocks of 4x4 tiles. A block is the 4x2 tiles at |src|
+// drawn twice, so every other row of the area is the same, and the rows are
+// built once and copied down.
+static void RoomDraw_FillBlocks(uint16 *dst, const uint16 *src, int w, int h) {
+  uint16 rows[2][64];
+  assert(w >= 1 && w <= 16);
+  for (int x = 0; x < w * 4; x++) {
+    rows[0][x] = src[x & 3];
+    rows[1][x] = src[4 + (x & 3)];
   }
+  for (int y = 0; y < h * 4; y++)
+    memcpy(dst + XY(0, y), rows[y & 1], w * 4 * sizeof(uint16));
+}
+
+void RoomDraw_FloorChunks(const uint16 *src) {  // 818a1f
+  // The four 32x32 quadrants together cover the whole tilemap
+  RoomDraw_FillBlocks(DstoPtr(0), src, 16, 16);
 }
 
 void RoomDraw_A_Many32x32Blocks(int n, const uint16 *src, uint16 *dst) {  // 818a44
-  do {
-    // draw 4x2 twice
-    for (int i = 0; i < 2; i++) {
-      dst[XY(0, 0)] = src[0];
-      dst[XY(1, 0)] = src[1];
-      dst[XY(2, 0)] = src[2];
-      dst[XY(3, 0)] = src[3];
-      dst[XY(0, 1)] = src[4];
-      dst[XY(1, 1)] = src[5];
-      dst[XY(2, 1)] = src[6];
-      dst[XY(3, 1)] = src[7];
-      dst += XY(0, 2);
-    }
-    dst += XY(4, -4);
-  } while (--n);
+  RoomDraw_FillBlocks(dst, src, n, 1);
 }
 
 void RoomDraw_1x3_rightwards(int n, const uint16 *src, uint16 *dst) {  // 818d80
@@ -0,0 +1,79 @@
+// Conversion of 3bpp tiles to the 4bpp format of vram. This has no other
+// dependencies on the game than ram and the vram journal, so that
+// other/gfx_3to4_check can check it on its own.
+#include "zelda_rtl.h"
+#include "variables.h"
+#include "load_gfx.h"
+#include "gfx_simd.h"
+
+// Converts a 3bpp tile (8 rows of planes 0 and 1, then 8 bytes of plane 2) to
+// 4bpp (8 rows of planes 0 and 1, then 8 rows of planes 2 and 3). With |high|,
+// plane 3 is set wherever the pixel is nonzero, selecting colors 9-15.
+static inline void Convert3To4Tile(uint8 *dst, const uint8 *src, bool high) {
+#if defined(GFX_USE_SSE2)
+  __m128i p01 = _mm_loadu_si128((const __m128i *)src);
+  __m128i p2 = _mm_loadl_epi64((const __m128i *)(src + 16));
+  __m128i p3 = _mm_setzero_si128();
+  if (high) {
+    __m128i rows = _mm_or_si128(p01, _mm_srli_epi16(p01, 8));
+    rows = _mm_packus_epi16(_mm_and_si128(rows, _mm_set1_epi16(0xff)), p3);
+    p3 = _mm_or_si128(rows, p2);
+  }
+  _mm_storeu_si128((__m128i *)dst, p01);
+  _mm_storeu_si128((__m128i *)(dst + 16), _mm_unpacklo_epi8(p2, p3));
+#elif defined(GFX_USE_NEON)
+  uint8x8x2_t p01 = vld2_u8(src), p23;
+  p23.val[0] = vld1_u8(src + 16);
+  p23.val[1] = high ? vorr_u8(vorr_u8(p01.val[0], p01.val[1]), p23.val[0]) : vdup_n_u8(0);
+  vst2_u8(dst, p01);
+  vst2_u8(dst + 16, p23);
+#else
+  for (int i = 0; i < 8; i++) {
+    uint8 p0 = src[i * 2], p1 = src[i * 2 + 1], p2 = src[16 + i];
+    dst[i * 2] = p0;
+    dst[i * 2 + 1] = p1;
+    dst[16 + i * 2] = p2;
+    dst[17 + i * 2] = high ? p0 | p1 | p2 : 0;
+  }
+#endif
+}
+
+static void Convert3To4Tiles(uint8 *dst, const uint8 *src, int num, bool high) {
+  for (; num > 0; num--, dst += 32, src += 24)
+    Convert3To4Tile(dst, src, high);
+}
+
+// Do3To4High leaves the combined planes of the last tile's rows in ram
+void SetDo3To4HighLeftovers(const uint8 *tile) {
+  uint16 *t = (uint16 *)&dung_line_ptrs_row0;
+  for (int i = 7; i >= 0; i--, tile += 2)
+    t[i] = tile[0] | tile[1];
+}
+
+void Expand3To4High(uint8 *dst, const uint8 *src, const uint8 *base, int num) {  // 80d61c
+  do {
+    Convert3To4Tile(dst, src, true);
+    dst += 32, src += 24;
+    if (!(src - base & 0x78))
+      src += 0x180;
+  } while (--num);
+}
+
+void Do3To4High16Bit(uint8 *dst, const uint8 *src, int num) {  // 80df4f
+  Convert3To4Tiles(dst, src, num, true);
+}
+
+void Do3To4Low16Bit(uint8 *dst, const uint8 *src, int num) {  // 80dfb8
+  Convert3To4Tiles(dst, src, num, false);
+}
+
+void Do3To4High(uint16 *vram_ptr, const uint8 *decomp_addr) {  // 80e5af
+  VramJournal_Mark(vram_ptr - g_zenv.vram, 64 * 16);
+  Convert3To4Tiles((uint8 *)vram_ptr, decomp_addr, 64, true);
+  SetDo3To4HighLeftovers(decomp_addr + 63 * 24);
+}
+
+void Do3To4Low(uint16 *vram_ptr, const uint8 *decomp_addr) {  // 80e63c
+  VramJournal_Mark(vram_ptr - g_zenv.vram, 64 * 16);
+  Convert3To4Tiles((uint8 *)vram_ptr, decomp_addr, 64, false);
+}
@@ -0,0 +1,14 @@
+#ifndef ZELDA3_GFX_SIMD_H_
+#define ZELDA3_GFX_SIMD_H_
+
+// SSE2 is always there on x64, and NEON on arm64. Other targets, such as the
+// 3DS, use the plain loops.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GFX_USE_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define GFX_USE_NEON 1
+#endif
+
+#endif  // ZELDA3_GFX_SIMD_H_
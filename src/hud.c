@@ -942,6 +942,7 @@ static void CopyTilesForSwitchLR(int switch_lr) {
       PV(1,1,1,3,3,1,1,1),
       PV(1,1,1,1,1,1,1,3)
     };
+    VramJournal_Mark(0x7000 + 0xc * 8, 8);
     memcpy(&g_zenv.vram[0x7000 + 0xc * 8], kBytesForNewTile0xC_TopOfR, sizeof(kBytesForNewTile0xC_TopOfR));
 
     static const uint16 kBytesForNewTile0xD_BottomofR[8] = {
@@ -954,6 +955,7 @@ static void CopyTilesForSwitchLR(int switch_lr) {
       PV(1,1,1,3,3,1,1,1),
       PV(1,1,1,3,3,1,1,1)
     };
+    VramJournal_Mark(0x7000 + 0xd * 8, 8);
     memcpy(&g_zenv.vram[0x7000 + 0xd * 8], kBytesForNewTile0xD_BottomofR, sizeof(kBytesForNewTile0xD_BottomofR));
   } else if (switch_lr == 2) {
     static const uint16 kBytesForNewTile0xE_TopOfL[8] = {
@@ -966,6 +968,7 @@ static void CopyTilesForSwitchLR(int switch_lr) {
       PV(1,1,1,3,3,3,3,3),
       PV(1,1,1,3,3,3,3,3)
     };
+    VramJournal_Mark(0x7000 + 0xe * 8, 8);
     memcpy(&g_zenv.vram[0x7000 + 0xe * 8], kBytesForNewTile0xE_TopOfL, sizeof(kBytesForNewTile0xE_TopOfL));
 
     static const uint16 kBytesForNewTile0xF_BottomofL[8] = {
@@ -978,6 +981,7 @@ static void CopyTilesForSwitchLR(int switch_lr) {
       PV(1,1,1,1,1,1,1,1),
       PV(1,1,1,1,1,1,1,1)
     };
+    VramJournal_Mark(0x7000 + 0xf * 8, 8);
     memcpy(&g_zenv.vram[0x7000 + 0xf * 8], kBytesForNewTile0xF_BottomofL, sizeof(kBytesForNewTile0xF_BottomofL));
   }
 #undef PV
@@ -6,6 +6,8 @@
 #include "player.h"
 #include "sprite.h"
 #include "assets.h"
+#include "util.h"
+#include "gfx_simd.h"
 
 // Allow this to be overwritten
 uint16 kGlovesColor[2] = {0x52f6, 0x376};
@@ -328,30 +330,93 @@ static const uint8 *GetCompSpritePtr(int i) {
   return kSprGfx(i).ptr;
 }
 
-void ApplyPaletteFilter_bounce() {
+// Palette math shared by the fades. Colors are BGR555, and a step adds |dir|
+// to each selected channel of the packed word, carries into the next channel
+// included, so the result matches the per channel adds of the original.
+enum {
+  kPalChan_R = 0x1f,
+  kPalChan_G = 0x3e0,
+  kPalChan_B = 0x7c00,
+  kPalChan_All = 0x7fff,
+};
 
-  const uint16 *load_ptr = kPaletteFilteringBits + (palette_filter_countdown >= 0x10);
+// Steps the |chans| of the |n| colors at |dst| by |dir| where they differ from
+// |target|, which is either |n| colors or, with |single|, one color for all.
+static void PaletteMath_Step(uint16 *dst, const uint16 *target, bool single, int n, uint16 chans, int dir) {
+  uint16 inc_r = chans & kPalChan_R ? dir : 0;
+  uint16 inc_g = chans & kPalChan_G ? dir * 0x20 : 0;
+  uint16 inc_b = chans & kPalChan_B ? dir * 0x400 : 0;
+  int i = 0;
+#if defined(GFX_USE_SSE2)
+  __m128i mr = _mm_set1_epi16(kPalChan_R), mg = _mm_set1_epi16(kPalChan_G), mb = _mm_set1_epi16(kPalChan_B);
+  __m128i vr = _mm_set1_epi16(inc_r), vg = _mm_set1_epi16(inc_g), vb = _mm_set1_epi16(inc_b);
+  __m128i tc = _mm_set1_epi16(target[0]);
+  for (; i + 8 <= n; i += 8) {
+    __m128i c = _mm_loadu_si128((const __m128i *)(dst + i));
+    __m128i t = single ? tc : _mm_loadu_si128((const __m128i *)(target + i));
+    __m128i d = _mm_andnot_si128(_mm_cmpeq_epi16(_mm_and_si128(c, mr), _mm_and_si128(t, mr)), vr);
+    d = _mm_add_epi16(d, _mm_andnot_si128(_mm_cmpeq_epi16(_mm_and_si128(c, mg), _mm_and_si128(t, mg)), vg));
+    d = _mm_add_epi16(d, _mm_andnot_si128(_mm_cmpeq_epi16(_mm_and_si128(c, mb), _mm_and_si128(t, mb)), vb));
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_add_epi16(c, d));
+  }
+#elif defined(GFX_USE_NEON)
+  uint16x8_t mr = vdupq_n_u16(kPalChan_R), mg = vdupq_n_u16(kPalChan_G), mb = vdupq_n_u16(kPalChan_B);
+  uint16x8_t vr = vdupq_n_u16(inc_r), vg = vdupq_n_u16(inc_g), vb = vdupq_n_u16(inc_b);
+  uint16x8_t tc = vdupq_n_u16(target[0]);
+  for (; i + 8 <= n; i += 8) {
+    uint16x8_t c = vld1q_u16(dst + i);
+    uint16x8_t t = single ? tc : vld1q_u16(target + i);
+    uint16x8_t d = vbicq_u16(vr, vceqq_u16(vandq_u16(c, mr), vandq_u16(t, mr)));
+    d = vaddq_u16(d, vbicq_u16(vg, vceqq_u16(vandq_u16(c, mg), vandq_u16(t, mg))));
+    d = vaddq_u16(d, vbicq_u16(vb, vceqq_u16(vandq_u16(c, mb), vandq_u16(t, mb))));
+    vst1q_u16(dst + i, vaddq_u16(c, d));
+  }
+#endif
+  for (; i < n; i++) {
+    uint16 c = dst[i], t = target[single ? 0 : i];
+    dst[i] = c + ((c & kPalChan_R) != (t & kPalChan_R) ? inc_r : 0) +
+                 ((c & kPalChan_G) != (t & kPalChan_G) ? inc_g : 0) +
+                 ((c & kPalChan_B) != (t & kPalChan_B) ? inc_b : 0);
+  }
+}
+
+static void PaletteMath_StepTowardAux(int from, int to, uint16 chans, int dir) {
+  PaletteMath_Step(main_palette_buffer + from, aux_palette_buffer + from, false, to - from, chans, dir);
+}
 
+static void PaletteMath_StepTowardColor(int from, int to, uint16 color, uint16 chans, int dir) {
+  PaletteMath_Step(main_palette_buffer + from, &color, true, to - from, chans, dir);
+}
+
+// The dithered fade steps a channel unless the current level's bit for that
+// channel's value in the aux palette is set. Returns the channel values that
+// step at this level as a bitmask, so the table is walked once per call.
+static uint32 PaletteMath_DitherBits() {
+  const uint16 *load_ptr = kPaletteFilteringBits + (palette_filter_countdown >= 0x10);
   int mask = kUpperBitmasks[palette_filter_countdown & 0xf];
-  int dt = darkening_or_lightening_screen ? 1 : -1;
-  int j = 0;
-  for (;;) {
-    uint16 c = main_palette_buffer[j], a = aux_palette_buffer[j];
-    if (!(load_ptr[(a & 0x1f) * 2] & mask))
-      c += dt;
-    if (!(load_ptr[(a & 0x3e0) >> 4] & mask))
-      c += dt << 5;
-    if (!(load_ptr[(a & 0x7c00) >> 9] & mask))
-      c += dt << 10;
-    main_palette_buffer[j] = c;
-    j++;
-    if (j == 1)
-      j = 0x20;
-    else if (j == 0xd8)
-      j = 0xe0;
-    else if (j == 0xf0)
-      break;
+  uint32 bits = 0;
+  for (int v = 0; v < 32; v++)
+    bits |= (uint32)!(load_ptr[v * 2] & mask) << v;
+  return bits;
+}
+
+// This one depends on a lookup per channel, which doesn't vectorize without
+// gathers, so it's branchless scalar code.
+static void PaletteMath_Dither(int from, int to, uint32 bits, int dir) {
+  for (int j = from; j != to; j++) {
+    uint16 a = aux_palette_buffer[j];
+    main_palette_buffer[j] += (bits >> (a & 0x1f) & 1) * dir +
+                              (bits >> (a >> 5 & 0x1f) & 1) * dir * 0x20 +
+                              (bits >> (a >> 10 & 0x1f) & 1) * dir * 0x400;
   }
+}
+
+void ApplyPaletteFilter_bounce() {
+  uint32 bits = PaletteMath_DitherBits();
+  int dt = darkening_or_lightening_screen ? 1 : -1;
+  PaletteMath_Dither(0, 1, bits, dt);
+  PaletteMath_Dither(0x20, 0xd8, bits, dt);
+  PaletteMath_Dither(0xe0, 0xf0, bits, dt);
   flag_update_cgram_in_nmi++;
   if (!darkening_or_lightening_screen) {
     if (++palette_filter_countdown != mosaic_target_level)
@@ -366,19 +431,7 @@ void ApplyPaletteFilter_bounce() {
 }
 
 void PaletteFilter_Range(int from, int to) {
-  const uint16 *load_ptr = kPaletteFilteringBits + (palette_filter_countdown >= 0x10);
-  int mask = kUpperBitmasks[palette_filter_countdown & 0xf];
-  int dt = darkening_or_lightening_screen ? 1 : -1;
-  for (int j = from; j != to; j++) {
-    uint16 c = main_palette_buffer[j], a = aux_palette_buffer[j];
-    if (!(load_ptr[(a & 0x1f) * 2] & mask))
-      c += dt;
-    if (!(load_ptr[(a & 0x3e0) >> 4] & mask))
-      c += dt << 5;
-    if (!(load_ptr[(a & 0x7c00) >> 9] & mask))
-      c += dt << 10;
-    main_palette_buffer[j] = c;
-  }
+  PaletteMath_Dither(from, to, PaletteMath_DitherBits(), darkening_or_lightening_screen ? 1 : -1);
 }
 
 void PaletteFilter_IncrCountdown() {
@@ -412,6 +465,7 @@ void EraseTileMaps_normal() {
 static void DecompAndUpload2bpp(uint16 *vram_ptr, uint8 pack) {
   Decomp_spr(&g_ram[0x14000], pack);
   const uint8 *src = &g_ram[0x14000];
+  VramJournal_Mark(vram_ptr - g_zenv.vram, 1024);
   memcpy(vram_ptr, src, 1024 * sizeof(uint16));
 }
 
@@ -435,6 +489,8 @@ void EraseTileMaps_dungeonmap() {  // 80833f
 }
 
 void EraseTileMaps(uint16 r2, uint16 r0) {  // 808355
+  VramJournal_Mark(0, 0x2000);
+  VramJournal_Mark(0x6000, 0x800);
   uint16 *dst = g_zenv.vram;
   for (int i = 0; i < 0x2000; i++)
     dst[i] = r0;
@@ -563,23 +619,6 @@ void DecodeAnimatedSpriteTile_variable(uint8 a) {  // 80d4ed
   WriteTo4BPPBuffer_at_7F4000(a);
 }
 
-void Expand3To4High(uint8 *dst, const uint8 *src, const uint8 *base, int num) {  // 80d61c
-  do {
-    const uint8 *src2 = src + 0x10;
-    int n = 8;
-    do {
-      uint16 t = WORD(src[0]);
-      uint8 u = src2[0];
-      WORD(dst[0]) = t;
-      WORD(dst[0x10]) = (t | (t >> 8) | u) << 8 | u;
-      src += 2, src2 += 1, dst += 2;
-    } while (--n);
-    dst += 16, src = src2;
-    if (!(src - base & 0x78))
-      src += 0x180;
-  } while (--num);
-}
-
 void LoadTransAuxGFX() {  // 80d66e
   uint8 *dst = &g_ram[0x6000];
   const uint8 *p = kAuxTilesets[aux_tile_theme_index];
@@ -774,35 +813,6 @@ void PrepTransAuxGfx() {  // 80df1a
   }
 }
 
-void Do3To4High16Bit(uint8 *dst, const uint8 *src, int num) {  // 80df4f
-  do {
-    const uint8 *src2 = src + 0x10;
-    int n = 8;
-    do {
-      uint16 t = WORD(src[0]);
-      uint8 u = src2[0];
-      WORD(dst[0]) = t;
-      WORD(dst[0x10]) = (t | (t >> 8) | u) << 8 | u;
-      src += 2, src2 += 1, dst += 2;
-    } while (--n);
-    dst += 16, src = src2;
-  } while (--num);
-
-}
-
-void Do3To4Low16Bit(uint8 *dst, const uint8 *src, int num) {  // 80dfb8
-  do {
-    const uint8 *src2 = src + 0x10;
-    int n = 8;
-    do {
-      WORD(dst[0]) = WORD(src[0]);
-      WORD(dst[0x10]) = src2[0];
-      src += 2, src2 += 1, dst += 2;
-    } while (--n);
-    dst += 16, src = src2;
-  } while (--num);
-}
-
 void LoadNewSpriteGFXSet() {  // 80e031
   Do3To4Low16Bit(&g_ram[0x10000], &g_ram[0x7800], 0xC0);
   if (sprite_gfx_subset_3 == 0x52 || sprite_gfx_subset_3 == 0x53 || sprite_gfx_subset_3 == 0x5a || sprite_gfx_subset_3 == 0x5b)
@@ -848,6 +858,7 @@ void LoadDefaultGraphics() {  // 80e2d0
 
   uint16 *vram_ptr = &g_zenv.vram[0x4000];
   uint16 *tmp = (uint16 *)&g_ram[0xbf];
+  VramJournal_Mark(0x4000, 64 * 16);
   int num = 64;
   do {
     for (int i = 7; i >= 0; i--, src += 2) {
@@ -932,55 +943,58 @@ void Graphics_LoadChrHalfSlot() {  // 80e3fa
 }
 
 void TransferFontToVRAM() {  // 80e556
+  VramJournal_Mark(0x7000, 0x800);
   memcpy(&g_zenv.vram[0x7000], FindIndexInMemblk(kDialogueFont(0), 0).ptr, 0x800 * sizeof(uint16));
 }
 
-void Do3To4High(uint16 *vram_ptr, const uint8 *decomp_addr) {  // 80e5af
-  for (int j = 0; j < 64; j++) {
-    uint16 *t = (uint16 *)&dung_line_ptrs_row0;
-    for (int i = 7; i >= 0; i--, decomp_addr += 2) {
-      uint16 d = *(uint16 *)decomp_addr;
-      t[i] = (d | (d >> 8)) & 0xff;
-      *vram_ptr++ = d;
-    }
-    for (int i = 7; i >= 0; i--, decomp_addr += 1) {
-      uint8 d = *decomp_addr;
-      *vram_ptr++ = d | (t[i] | d) << 8;
-    }
+
+enum {
+  // A 3bpp sheet followed by its two 4bpp expansions
+  kPreExpandedSheetSize = 0x600 + 0x800 * 2,
+};
+
+// With kAssetsFlag_PreExpandedGfx, the sheets are stored decompressed, and the
+// 3bpp ones are followed by the tiles that Do3To4High and Do3To4Low make out
+// of them, so loading a sheet is just copies.
+static void Do3To4(uint16 *vram_ptr, const uint8 *decomp_addr, MemBlk blk, bool high) {
+  if (!(g_asset_flags & kAssetsFlag_PreExpandedGfx) || blk.size != kPreExpandedSheetSize) {
+    if (high)
+      Do3To4High(vram_ptr, decomp_addr);
+    else
+      Do3To4Low(vram_ptr, decomp_addr);
+    return;
   }
+  VramJournal_Mark(vram_ptr - g_zenv.vram, 0x400);
+  memcpy(vram_ptr, blk.ptr + 0x600 + (high ? 0 : 0x800), 0x800);
+  if (high)
+    SetDo3To4HighLeftovers(decomp_addr + 63 * 24);
 }
 
-void Do3To4Low(uint16 *vram_ptr, const uint8 *decomp_addr) {  // 80e63c
-  for (int j = 0; j < 64; j++) {
-    for (int i = 0; i < 8; i++, decomp_addr += 2)
-      *vram_ptr++ = *(uint16 *)decomp_addr;
-    for (int i = 0; i < 8; i++, decomp_addr += 1)
-      *vram_ptr++ = *decomp_addr;
-  }
+static int CopyPreExpandedSheet(uint8 *dst, MemBlk blk) {
+  int len = blk.size == kPreExpandedSheetSize ? 0x600 : blk.size;
+  memcpy(dst, blk.ptr, len);
+  return len;
 }
 
 void LoadSpriteGraphics(uint16 *vram_ptr, int gfx_pack, uint8 *decomp_addr) {  // 80e583
   Decomp_spr(decomp_addr, gfx_pack);
-  if (gfx_pack == 0x52 || gfx_pack == 0x53 || gfx_pack == 0x5a || gfx_pack == 0x5b ||
-      gfx_pack == 0x5c || gfx_pack == 0x5e || gfx_pack == 0x5f)
-    Do3To4High(vram_ptr, decomp_addr);
-  else
-    Do3To4Low(vram_ptr, decomp_addr);
+  bool high = (gfx_pack == 0x52 || gfx_pack == 0x53 || gfx_pack == 0x5a || gfx_pack == 0x5b ||
+               gfx_pack == 0x5c || gfx_pack == 0x5e || gfx_pack == 0x5f);
+  // Same sheet as Decomp_spr picks
+  Do3To4(vram_ptr, decomp_addr, kSprGfx(gfx_pack < 12 ? 12 : gfx_pack), high);
 }
 
 void LoadBackgroundGraphics(uint16 *vram_ptr, int gfx_pack, int slot, uint8 *decomp_addr) {  // 80e609
   Decomp_bg(decomp_addr, gfx_pack);
-  if ((main_tile_theme_index >= 0x20) ? (slot == 7 || slot == 2 || slot == 3 || slot == 4) : (slot >= 4))
-    Do3To4High(vram_ptr, decomp_addr);
-  else
-    Do3To4Low(vram_ptr, decomp_addr);
+  bool high = (main_tile_theme_index >= 0x20) ? (slot == 7 || slot == 2 || slot == 3 || slot == 4) : (slot >= 4);
+  Do3To4(vram_ptr, decomp_addr, kBgGfx(gfx_pack), high);
 }
 
 void LoadCommonSprites() {  // 80e6b7
-  Do3To4High(&g_zenv.vram[0x4400], GetCompSpritePtr(misc_sprites_graphics_index));
+  Do3To4(&g_zenv.vram[0x4400], GetCompSpritePtr(misc_sprites_graphics_index), kSprGfx(misc_sprites_graphics_index), true);
   if (main_module_index != 1) {
-    Do3To4Low(&g_zenv.vram[0x4800], GetCompSpritePtr(6));
-    Do3To4Low(&g_zenv.vram[0x4c00], GetCompSpritePtr(7));
+    Do3To4(&g_zenv.vram[0x4800], GetCompSpritePtr(6), kSprGfx(6), false);
+    Do3To4(&g_zenv.vram[0x4c00], GetCompSpritePtr(7), kSprGfx(7), false);
   } else {
     // select file
     LoadSpriteGraphics(&g_zenv.vram[0x4800], 94, &g_ram[0x14000]);
@@ -988,70 +1002,80 @@ void LoadCommonSprites() {  // 80e6b7
   }
 }
 
+// Least recently used decompressed sheets, so that going back and forth
+// between areas turns into memcpys instead of decompressing the same sheets
+// over and over.
+typedef struct GfxSheetCacheEnt {
+  uint32 key;
+  uint32 size;
+  uint32 last_used;
+  uint8 *data;
+} GfxSheetCacheEnt;
+
+static GfxSheetCacheEnt *g_gfx_sheet_cache;
+static int g_gfx_sheet_cache_size;
+static uint32 g_gfx_sheet_cache_clock;
+
+enum {
+  kGfxSheetKey_Bg = 0,
+  kGfxSheetKey_Spr = 0x10000,
+};
+
+void ZeldaSetGfxSheetCacheSize(int sheets) {
+  for (int i = 0; i < g_gfx_sheet_cache_size; i++)
+    free(g_gfx_sheet_cache[i].data);
+  free(g_gfx_sheet_cache);
+  g_gfx_sheet_cache = sheets > 0 ? calloc(sheets, sizeof(GfxSheetCacheEnt)) : NULL;
+  g_gfx_sheet_cache_size = g_gfx_sheet_cache ? sheets : 0;
+}
+
+static int DecompressCached(uint8 *dst, MemBlk src, uint32 key) {
+  GfxSheetCacheEnt *ent = g_gfx_sheet_cache, *victim = ent;
+  for (int i = 0; i < g_gfx_sheet_cache_size; i++, ent++) {
+    if (ent->data && ent->key == key) {
+      ent->last_used = ++g_gfx_sheet_cache_clock;
+      memcpy(dst, ent->data, ent->size);
+      return ent->size;
+    }
+    if (victim->data && (!ent->data || ent->last_used < victim->last_used))
+      victim = ent;
+  }
+  int len = Decompress(dst, src);
+  if (victim && len > 0) {
+    uint8 *data = realloc(victim->data, len);
+    if (data) {
+      memcpy(data, dst, len);
+      victim->data = data;
+      victim->key = key;
+      victim->size = len;
+      victim->last_used = ++g_gfx_sheet_cache_clock;
+    }
+  }
+  return len;
+}
+
 int Decomp_spr(uint8 *dst, int gfx) {  // 80e772
   if (gfx < 12)
     gfx = 12; // ensure it wont decode bad sheets.
   MemBlk blk = kSprGfx(gfx);
+  if (g_asset_flags & kAssetsFlag_PreExpandedGfx)
+    return CopyPreExpandedSheet(dst, blk);
   const uint8 *sprite_data = GetCompSpritePtr(gfx);
   // If the size is not 0x600 then it's compressed
   if (gfx >= 103 || blk.size != 0x600)
-    return Decompress(dst, blk.ptr);
+    return DecompressCached(dst, blk, kGfxSheetKey_Spr | gfx);
   memcpy(dst, blk.ptr, 0x600);
   return 0x600;
 }
 
 int Decomp_bg(uint8 *dst, int gfx) {  // 80e78f
-  return Decompress(dst, kBgGfx(gfx).ptr);
+  if (g_asset_flags & kAssetsFlag_PreExpandedGfx)
+    return CopyPreExpandedSheet(dst, kBgGfx(gfx));
+  return DecompressCached(dst, kBgGfx(gfx), kGfxSheetKey_Bg | gfx);
 }
 
-int Decompress(uint8 *dst, const uint8 *src) {  // 80e79e
-  uint8 *dst_org = dst;
-  int len;
-  for (;;) {
-    uint8 cmd = *src++;
-    if (cmd == 0xff)
-      return dst - dst_org;
-    if ((cmd & 0xe0) != 0xe0) {
-      len = (cmd & 0x1f) + 1;
-      cmd &= 0xe0;
-    } else {
-      len = *src++;
-      len += ((cmd & 3) << 8) + 1;
-      cmd = (cmd << 3) & 0xe0;
-    }
-    //printf("%d: %d,%d\n", (int)(dst - dst_org), cmd, len);
-    if (cmd == 0) {
-      do {
-        *dst++ = *src++;
-      } while (--len);
-    } else if (cmd & 0x80) {
-      uint32 offs = *src++;
-      offs |= *src++ << 8;
-      do {
-        *dst++ = dst_org[offs++];
-      } while (--len);
-    } else if (!(cmd & 0x40)) {
-      uint8 v = *src++;
-      do {
-        *dst++ = v;
-      } while (--len);
-    } else if (!(cmd & 0x20)) {
-      uint8 lo = *src++;
-      uint8 hi = *src++;
-      do {
-        *dst++ = lo;
-        if (--len == 0)
-          break;
-        *dst++ = hi;
-      } while (--len);
-    } else {
-      // copy bytes with the byte incrementing by 1 in between
-      uint8 v = *src++;
-      do {
-        *dst++ = v;
-      } while (v++, --len);
-    }
-  }
+int Decompress(uint8 *dst, MemBlk src) {  // 80e79e
+  return DecompressLz(dst, src, false);
 }
 
 void ResetHUDPalettes4and5() {  // 80eb29
@@ -1155,33 +1179,11 @@ void Palette_FadeIntro2() {  // 80ed8f
 }
 
 void PaletteFilter_RestoreAdditive(int from, int to) {  // 80edca
-  from >>= 1, to >>= 1;
-  do {
-    uint16 c = main_palette_buffer[from], cx = c;
-    uint16 d = aux_palette_buffer[from];
-    if ((c & 0x1f) != (d & 0x1f))
-      cx += 1;
-    if ((c & 0x3e0) != (d & 0x3e0))
-      cx += 0x20;
-    if ((c & 0x7c00) != (d & 0x7c00))
-      cx += 0x400;
-    main_palette_buffer[from] = cx;
-  } while (++from != to);
+  PaletteMath_StepTowardAux(from >> 1, to >> 1, kPalChan_All, 1);
 }
 
 void PaletteFilter_RestoreSubtractive(uint16 from, uint16 to) {  // 80ee21
-  from >>= 1, to >>= 1;
-  do {
-    uint16 c = main_palette_buffer[from], cx = c;
-    uint16 d = aux_palette_buffer[from];
-    if ((c & 0x1f) != (d & 0x1f))
-      cx -= 1;
-    if ((c & 0x3e0) != (d & 0x3e0))
-      cx -= 0x20;
-    if ((c & 0x7c00) != (d & 0x7c00))
-      cx -= 0x400;
-    main_palette_buffer[from] = cx;
-  } while (++from != to);
+  PaletteMath_StepTowardAux(from >> 1, to >> 1, kPalChan_All, -1);
 }
 
 void PaletteFilter_InitializeWhiteFilter() {  // 80ee78
@@ -1250,12 +1252,7 @@ void PaletteFilter_BlindingWhiteTriforce() {  // 80ef8a
 
 void PaletteFilter_WhirlpoolBlue() {  // 80ef97
   if (frame_counter & 1) {
-    for (int i = 0x20; i != 0x100; i++) {
-      uint16 t = main_palette_buffer[i];
-      if ((t & 0x7C00) != 0x7C00)
-        t += 0x400;
-      main_palette_buffer[i] = t;
-    }
+    PaletteMath_StepTowardColor(0x20, 0x100, 0x7c00, kPalChan_B, 1);
     main_palette_buffer[0] = main_palette_buffer[32];
     if (!(palette_filter_countdown & 1))
       mosaic_level += 16;
@@ -1271,14 +1268,7 @@ void PaletteFilter_WhirlpoolBlue() {  // 80ef97
 }
 
 void PaletteFilter_IsolateWhirlpoolBlue() {  // 80f00c
-  for (int i = 0x20; i != 0x100; i++) {
-    uint16 t = main_palette_buffer[i];
-    if (t & 0x3e0)
-      t -= 0x20;
-    if (t & 0x1f)
-      t -= 1;
-    main_palette_buffer[i] = t;
-  }
+  PaletteMath_StepTowardColor(0x20, 0x100, 0, kPalChan_R | kPalChan_G, -1);
   main_palette_buffer[0] = main_palette_buffer[32];
   if (++palette_filter_countdown == 31) {
     palette_filter_countdown = 0;
@@ -1292,13 +1282,7 @@ void PaletteFilter_IsolateWhirlpoolBlue() {  // 80f00c
 
 void PaletteFilter_WhirlpoolRestoreBlue() {  // 80f04a
   if (frame_counter & 1) {
-    for (int i = 0x20; i != 0x100; i++) {
-      uint16 u = aux_palette_buffer[i] & 0x7c00;
-      uint16 t = main_palette_buffer[i];
-      if ((t & 0x7C00) != u)
-        t -= 0x400;
-      main_palette_buffer[i] = t;
-    }
+    PaletteMath_StepTowardAux(0x20, 0x100, kPalChan_B, -1);
     main_palette_buffer[0] = main_palette_buffer[32];
     if (!(palette_filter_countdown & 1))
       mosaic_level -= 16;
@@ -1314,16 +1298,7 @@ void PaletteFilter_WhirlpoolRestoreBlue() {  // 80f04a
 }
 
 void PaletteFilter_WhirlpoolRestoreRedGreen() {  // 80f0c7
-  for (int i = 0x20; i != 0x100; i++) {
-    uint16 u0 = aux_palette_buffer[i] & 0x3e0;
-    uint16 u1 = aux_palette_buffer[i] & 0x1f;
-    uint16 t = main_palette_buffer[i];
-    if ((t & 0x3e0) != u0)
-      t += 0x20;
-    if ((t & 0x1f) != u1)
-      t += 1;
-    main_palette_buffer[i] = t;
-  }
+  PaletteMath_StepTowardAux(0x20, 0x100, kPalChan_R | kPalChan_G, 1);
   main_palette_buffer[0] = main_palette_buffer[32];
   if (++palette_filter_countdown == 31) {
     palette_filter_countdown = 0;
@@ -54,12 +54,13 @@ void Graphics_LoadChrHalfSlot();
 void TransferFontToVRAM();
 void Do3To4High(uint16 *vram_ptr, const uint8 *decomp_addr);
 void Do3To4Low(uint16 *vram_ptr, const uint8 *decomp_addr);
+void SetDo3To4HighLeftovers(const uint8 *tile);
 void LoadSpriteGraphics(uint16 *vram_ptr, int gfx_pack, uint8 *decomp_addr);
 void LoadBackgroundGraphics(uint16 *vram_ptr, int gfx_pack, int slot, uint8 *decomp_addr);
 void LoadCommonSprites();
 int Decomp_spr(uint8 *dst, int gfx);
 int Decomp_bg(uint8 *dst, int gfx);
-int Decompress(uint8 *dst, const uint8 *src);
+int Decompress(uint8 *dst, MemBlk src);
 void ResetHUDPalettes4and5();
 void PaletteFilterHistory();
 void PaletteFilter_WishPonds();
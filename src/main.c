@@ -26,6 +26,8 @@
 #include "load_gfx.h"
 #include "util.h"
 #include "audio.h"
+#include "audio_output.h"
+#include "sprite.h"
 
 static bool g_run_without_emu = 0;
 
@@ -172,32 +174,111 @@ static void DrawPpuFrameWithPerf() {
 }
 
 static SDL_mutex *g_audio_mutex;
-static uint8 *g_audiobuffer, *g_audiobuffer_cur, *g_audiobuffer_end;
-static int g_frames_per_block;
-static uint8 g_audio_channels;
+static SDL_AudioDeviceID g_audio_device;
+static int g_audio_device_samples;
 
 static void SDLCALL AudioCallback(void *userdata, Uint8 *stream, int len) {
   if (SDL_LockMutex(g_audio_mutex)) Die("Mutex lock failed!");
-  while (len != 0) {
-    if (g_audiobuffer_end - g_audiobuffer_cur == 0) {
-      ZeldaRenderAudio((int16*)g_audiobuffer, g_frames_per_block, g_audio_channels);
-      g_audiobuffer_cur = g_audiobuffer;
-      g_audiobuffer_end = g_audiobuffer + g_frames_per_block * g_audio_channels * sizeof(int16);
-    }
-    int n = IntMin(len, g_audiobuffer_end - g_audiobuffer_cur);
-    if (g_sdl_audio_mixer_volume == SDL_MIX_MAXVOLUME) {
-      memcpy(stream, g_audiobuffer_cur, n);
-    } else {
-      SDL_memset(stream, 0, n);
-      SDL_MixAudioFormat(stream, g_audiobuffer_cur, AUDIO_S16, n, g_sdl_audio_mixer_volume);
-    }
-    g_audiobuffer_cur += n;
-    stream += n;
-    len -= n;
+  AudioOutput_Fill(stream, len, g_sdl_audio_mixer_volume);
+  SDL_UnlockMutex(g_audio_mutex);
+}
+
+static bool SdlAudioOutput_Open(int *freq, int *channels, int *samples) {
+  SDL_AudioSpec want = { 0 }, have;
+  want.freq = *freq;
+  want.format = AUDIO_S16;
+  want.channels = *channels;
+  want.samples = *samples;
+  want.callback = &AudioCallback;
+  g_audio_device = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
+  if (g_audio_device == 0) {
+    printf("Failed to open audio device: %s\n", SDL_GetError());
+    return false;
   }
+  *freq = have.freq;
+  *channels = have.channels;
+  *samples = g_audio_device_samples = have.samples;
+  return true;
+}
+
+static void SdlAudioOutput_Close() {
+  SDL_PauseAudioDevice(g_audio_device, 1);
+  SDL_CloseAudioDevice(g_audio_device);
+}
+
+static void SdlAudioOutput_SetPaused(bool paused) {
+  SDL_PauseAudioDevice(g_audio_device, paused);
+}
 
-  ZeldaDiscardUnusedAudioFrames();
+static int SdlAudioOutput_GetQueuedFrames() {
+  return g_audio_device_samples;
+}
+
+static const AudioOutputFuncs kSdlAudioOutput = {
+  &SdlAudioOutput_Open,
+  &SdlAudioOutput_Close,
+  &SdlAudioOutput_SetPaused,
+  NULL,
+  &SdlAudioOutput_GetQueuedFrames,
+};
+
+static const AudioOutputFuncs *g_audio_output;
+static int g_audio_freq, g_audio_channels, g_audio_block_frames;
+static int16 *g_audio_block;
+static SDL_Thread *g_audio_producer_thread;
+static volatile bool g_audio_producer_quit, g_audio_producer_paused = true;
+
+// Renders one block of audio and pushes it to an output without a callback.
+static void ProduceAudioBlock() {
+  SDL_LockMutex(g_audio_mutex);
+  AudioOutput_Fill((uint8 *)g_audio_block, g_audio_block_frames * g_audio_channels * sizeof(int16), g_sdl_audio_mixer_volume);
   SDL_UnlockMutex(g_audio_mutex);
+  g_audio_output->Write(g_audio_block, g_audio_block_frames);
+}
+
+static SDL_Thread *g_msu_decoder_thread;
+static volatile bool g_msu_decoder_quit;
+
+// Keeps the MSU ring buffers filled so the audio callback never waits for the disk.
+static int SDLCALL MsuDecoderThread(void *userdata) {
+  while (!g_msu_decoder_quit) {
+    if (!ZeldaMsuDecodeAhead())
+      SDL_Delay(2);
+  }
+  return 0;
+}
+
+// Drives outputs without a callback at the pace of a sound card that plays one
+// block at a time. Millisecond accuracy is plenty here, so no spinning.
+static int SDLCALL AudioProducerThread(void *userdata) {
+  uint64 freq = SDL_GetPerformanceFrequency();
+  uint64 period = freq * g_audio_block_frames / g_audio_freq;
+  uint64 deadline = SDL_GetPerformanceCounter();
+  while (!g_audio_producer_quit) {
+    if (!g_audio_producer_paused)
+      ProduceAudioBlock();
+    deadline += period;
+    uint64 now = SDL_GetPerformanceCounter();
+    if (now > deadline + freq / 10)
+      deadline = now;  // Don't try to catch up after a long stall
+    else if (now < deadline)
+      SDL_Delay((uint32)((deadline - now) * 1000 / freq));
+  }
+  return 0;
+}
+
+// Sleep until the performance counter reaches |deadline|. SDL_Delay is too coarse
+// to hit the deadline exactly, so sleep most of the time and spin for the rest.
+static void SleepUntilPerformanceCounter(uint64 deadline) {
+  uint64 freq = SDL_GetPerformanceFrequency();
+  for (;;) {
+    uint64 now = SDL_GetPerformanceCounter();
+    if (now >= deadline)
+      break;
+    uint64 ms = (deadline - now) * 1000 / freq;
+    if (ms > 2)
+      SDL_Delay((uint32)(ms - 2));
+  }
 }
 
 // State for sdl renderer
@@ -305,6 +386,9 @@ int main(int argc, char** argv) {
                        g_config.no_sprite_limits * kPpuRenderFlags_NoSpriteLimits;
   ZeldaEnableMsu(g_config.enable_msu);
   ZeldaSetLanguage(g_config.language);
+  ZeldaSetGfxSheetCacheSize(g_config.gfx_sheet_cache);
+  if (g_config.sprite_profile)
+    Sprite_EnableProfiling(&SDL_GetPerformanceCounter, SDL_GetPerformanceFrequency());
 
   if (g_config.fullscreen == 1)
     g_win_flags ^= SDL_WINDOW_FULLSCREEN_DESKTOP;
@@ -355,25 +439,31 @@ int main(int argc, char** argv) {
   if (!g_renderer_funcs.Initialize(window))
     return 1;
 
-  SDL_AudioDeviceID device = 0;
-  SDL_AudioSpec want = { 0 }, have;
   g_audio_mutex = SDL_CreateMutex();
   if (!g_audio_mutex) Die("No mutex");
 
   if (g_config.enable_audio) {
-    want.freq = g_config.audio_freq;
-    want.format = AUDIO_S16;
-    want.channels = g_config.audio_channels;
-    want.samples = g_config.audio_samples;
-    want.callback = &AudioCallback;
-    device = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
-    if (device == 0) {
-      printf("Failed to open audio device: %s\n", SDL_GetError());
+    g_audio_output = g_config.audio_output == kAudioOutput_Null ? &kNullAudioOutput :
+                     g_config.audio_output == kAudioOutput_Wav ? &kWavAudioOutput : &kSdlAudioOutput;
+    int samples = g_config.audio_samples;
+    g_audio_freq = g_config.audio_freq;
+    g_audio_channels = g_config.audio_channels;
+    if (!g_audio_output->Open(&g_audio_freq, &g_audio_channels, &samples))
       return 1;
+    bool per_frame = g_audio_output->Write && g_config.audio_render_per_frame;
+    AudioOutput_Init(g_audio_freq, g_audio_channels, g_config.adaptive_frame_pacing && !per_frame);
+    if (g_audio_output->Write) {
+      g_audio_block_frames = per_frame ? AudioOutput_GetFramesPerBlock() : samples;
+      g_audio_block = malloc(g_audio_block_frames * g_audio_channels * sizeof(int16));
+      if (!per_frame)
+        g_audio_producer_thread = SDL_CreateThread(&AudioProducerThread, "AudioProducer", NULL);
+    }
+
+    if (g_config.enable_msu) {
+      g_msu_decoder_thread = SDL_CreateThread(&MsuDecoderThread, "MsuDecoder", NULL);
+      if (g_msu_decoder_thread)
+        ZeldaMsuSetDecoderThread(true);
     }
-    g_audio_channels = have.channels;
-    g_frames_per_block = (534 * have.freq) / 32000;
-    g_audiobuffer = malloc(g_frames_per_block * have.channels * sizeof(int16));
   }
 
   if (argc >= 1 && !g_run_without_emu)
@@ -396,6 +486,7 @@ int main(int argc, char** argv) {
   uint32 curTick = 0;
   uint32 frameCtr = 0;
   bool audiopaused = true;
+  uint64 frame_deadline = SDL_GetPerformanceCounter();
 
   if (g_config.autosave)
     HandleCommand(kKeys_Load + 0, true);
@@ -442,8 +533,10 @@ int main(int argc, char** argv) {
 
     if (g_paused != audiopaused) {
       audiopaused = g_paused;
-      if (device)
-        SDL_PauseAudioDevice(device, audiopaused);
+      if (g_audio_output) {
+        g_audio_output->SetPaused(audiopaused);
+        g_audio_producer_paused = audiopaused;
+      }
     }
 
     if (g_paused) {
@@ -461,24 +554,47 @@ int main(int argc, char** argv) {
     bool is_replay = ZeldaRunFrame(inputs);
     SDL_UnlockMutex(g_audio_mutex);
 
+    // One snes frame of audio per game frame, without a producer thread
+    if (g_audio_block && !g_audio_producer_thread)
+      ProduceAudioBlock();
+
     frameCtr++;
 
+    if (g_config.sprite_profile && frameCtr % (g_config.sprite_profile * 60) == 0)
+      Sprite_PrintProfile();
+
     if ((g_turbo ^ (is_replay & g_replay_turbo)) && (frameCtr & (g_turbo ? 0xf : 0x7f)) != 0) {
       continue;
     }
 
+    if (g_config.adaptive_frame_pacing) {
+      // Present frames at a steady 60 fps. If we fall behind by more than a frame,
+      // for example because vsync runs slower, restart from the current time
+      // and let the dynamic rate control adjust the audio.
+      uint64 frame_period = SDL_GetPerformanceFrequency() / 60;
+      uint64 now = SDL_GetPerformanceCounter();
+      frame_deadline += frame_period;
+      if (now > frame_deadline + frame_period)
+        frame_deadline = now;
+      else
+        SleepUntilPerformanceCounter(frame_deadline);
+    }
+
     DrawPpuFrameWithPerf();
 
     if (g_config.display_perf_title) {
-      char title[60];
-      snprintf(title, sizeof(title), "%s | FPS: %d", kWindowTitle, g_curr_fps);
+      char title[80];
+      if (g_audio_output)
+        snprintf(title, sizeof(title), "%s | FPS: %d | Audio: %d ms", kWindowTitle, g_curr_fps, AudioOutput_GetLatencyMs(g_audio_output));
+      else
+        snprintf(title, sizeof(title), "%s | FPS: %d", kWindowTitle, g_curr_fps);
       SDL_SetWindowTitle(g_window, title);
     }
 
     // if vsync isn't working, delay manually
     curTick = SDL_GetTicks();
 
-    if (!g_config.disable_frame_delay) {
+    if (!g_config.disable_frame_delay && !g_config.adaptive_frame_pacing) {
       static const uint8 delays[3] = { 17, 17, 16 }; // 60 fps
       lastTick += delays[frameCtr % 3];
 
@@ -499,13 +615,21 @@ int main(int argc, char** argv) {
     HandleCommand(kKeys_Save + 0, true);
 
   // clean sdl
-  if (g_config.enable_audio) {
-    SDL_PauseAudioDevice(device, 1);
-    SDL_CloseAudioDevice(device);
+  if (g_audio_producer_thread) {
+    g_audio_producer_quit = true;
+    SDL_WaitThread(g_audio_producer_thread, NULL);
+  }
+  if (g_audio_output)
+    g_audio_output->Close();
+
+  if (g_msu_decoder_thread) {
+    g_msu_decoder_quit = true;
+    SDL_WaitThread(g_msu_decoder_thread, NULL);
   }
 
   SDL_DestroyMutex(g_audio_mutex);
-  free(g_audiobuffer);
+  AudioOutput_Destroy();
+  free(g_audio_block);
 
   g_renderer_funcs.Destroy();
 
@@ -805,12 +929,13 @@ static void LoadLinkGraphics() {
 }
 
 
-const uint8 *g_asset_ptrs[kNumberOfAssets];
-uint32 g_asset_sizes[kNumberOfAssets];
-
 static void LoadAssets() {
   size_t length = 0;
-  uint8 *data = ReadWholeFile("zelda3_assets.dat", &length);
+  // Map the file so the assets get paged in when first used and are shared
+  // between instances. Copy on write, as some features patch the assets.
+  uint8 *data = MapWholeFile("zelda3_assets.dat", &length, true);
+  if (!data)
+    data = ReadWholeFile("zelda3_assets.dat", &length);
   if (!data) {
     size_t bps_length, bps_src_length;
     uint8 *bps, *bps_src;
@@ -825,24 +950,7 @@ static void LoadAssets() {
       Die("Unable to apply zelda3_assets.bps. Please make sure you got the right version of 'zelda3.sfc'");
   }
 
-  static const char kAssetsSig[] = { kAssets_Sig };
-
-  if (length < 16 + 32 + 32 + 8 + kNumberOfAssets * 4 ||
-      memcmp(data, kAssetsSig, 48) != 0 ||
-      *(uint32*)(data + 80) != kNumberOfAssets)
-    Die("Invalid assets file");
-
-  uint32 offset = 88 + kNumberOfAssets * 4 + *(uint32 *)(data + 84);
-
-  for (size_t i = 0; i < kNumberOfAssets; i++) {
-    uint32 size = *(uint32 *)(data + 88 + i * 4);
-    offset = (offset + 3) & ~3;
-    if ((uint64)offset + size > length)
-      Die("Assets file corruption");
-    g_asset_sizes[i] = size;
-    g_asset_ptrs[i] = data + offset;
-    offset += size;
-  }
+  LoadAssetsFromMemory(data, length);
 
   if (g_config.features0 & kFeatures0_DimFlashes) { // patch dungeon floor palettes
     kPalette_DungBgMain[0x484] = 0x70;
@@ -876,7 +984,3 @@ static void SwitchDirectory() {
       pos--;
   }
 }
-
-MemBlk FindInAssetArray(int asset, int idx) {
-  return FindIndexInMemblk((MemBlk) { g_asset_ptrs[asset], g_asset_sizes[asset] }, idx);
-}
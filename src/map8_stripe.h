@@ -0,0 +1,56 @@
+#ifndef ZELDA3_MAP8_STRIPE_H_
+#define ZELDA3_MAP8_STRIPE_H_
+
+#include <assert.h>
+#include "types.h"
+#include "gfx_simd.h"
+
+// Converts |n| map16 tiles to the map8 words of the two tile rows they cover.
+// A row stripe gets the top and bottom halves of the tiles, while a column
+// stripe (|column|) gets their left and right halves. |n| is even. |map8| is
+// the table from GetMap16toMap8Table.
+static inline void BuildMap8Stripe(uint16 *a, uint16 *b, const uint16 *map8, const uint16 *map16, int n, bool column) {
+  int i = 0;
+#if defined(GFX_USE_SSE2)
+  for (; i + 4 <= n; i += 4, a += 8, b += 8) {
+    assert(map16[i] < 0xea8 && map16[i + 1] < 0xea8 && map16[i + 2] < 0xea8 && map16[i + 3] < 0xea8);
+    __m128i t01 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)(map8 + map16[i + 0] * 4)),
+                                     _mm_loadl_epi64((const __m128i *)(map8 + map16[i + 1] * 4)));
+    __m128i t23 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)(map8 + map16[i + 2] * 4)),
+                                     _mm_loadl_epi64((const __m128i *)(map8 + map16[i + 3] * 4)));
+    if (column) {
+      t01 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(t01, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+      t23 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(t23, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+    }
+    // Gather the first and second pair of words of each tile
+    t01 = _mm_shuffle_epi32(t01, _MM_SHUFFLE(3, 1, 2, 0));
+    t23 = _mm_shuffle_epi32(t23, _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128((__m128i *)a, _mm_unpacklo_epi64(t01, t23));
+    _mm_storeu_si128((__m128i *)b, _mm_unpackhi_epi64(t01, t23));
+  }
+#elif defined(GFX_USE_NEON)
+  for (; i + 2 <= n; i += 2, a += 4, b += 4) {
+    assert(map16[i] < 0xea8 && map16[i + 1] < 0xea8);
+    uint16x4_t t0 = vld1_u16(map8 + map16[i + 0] * 4), t1 = vld1_u16(map8 + map16[i + 1] * 4);
+    if (column) {
+      uint16x4x2_t r = vuzp_u16(t0, t1);
+      vst1_u16(a, r.val[0]);
+      vst1_u16(b, r.val[1]);
+    } else {
+      uint32x2x2_t r = vtrn_u32(vreinterpret_u32_u16(t0), vreinterpret_u32_u16(t1));
+      vst1_u16(a, vreinterpret_u16_u32(r.val[0]));
+      vst1_u16(b, vreinterpret_u16_u32(r.val[1]));
+    }
+  }
+#endif
+  for (; i < n; i++, a += 2, b += 2) {
+    assert(map16[i] < 0xea8);
+    const uint16 *s = map8 + map16[i] * 4;
+    a[0] = s[0];
+    a[1] = s[column ? 2 : 1];
+    b[0] = s[column ? 1 : 2];
+    b[1] = s[3];
+  }
+}
+
+#endif  // ZELDA3_MAP8_STRIPE_H_
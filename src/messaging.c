@@ -16,6 +16,7 @@
 #include "attract.h"
 #include "nmi.h"
 #include "assets.h"
+#include "util.h"
 
 static void WorldMap_AddSprite(int spr, uint8 big, uint8 flags, uint8 ch, uint16 x, uint16 y);
 static bool WorldMap_CalculateOamCoordinates(Point16U *pt);
@@ -270,6 +271,7 @@ void SaveGameFile() {  // 80894a
 void TransferMode7Characters() {  // 80e399
   uint16 *dst = g_zenv.vram;
   const uint8 *src = kOverworldMapGfx;
+  VramJournal_Mark(0, 0x4000);
   for (int i = 0; i != 0x4000; i++)
     HIBYTE(dst[i]) = src[i];
 }
@@ -1277,6 +1279,7 @@ void WorldMap_SetUpHDMA() {  // 8abc96
 
 void WorldMap_FillTilemapWithEF() {  // 8abda5
   uint16 *dst = g_zenv.vram;
+  VramJournal_Mark(0, 0x4000);
   for (int i = 0; i != 0x4000; i++)
     BYTE(dst[i]) = 0xef;
 }
@@ -2261,25 +2264,109 @@ uint32 Text_DecodeCmd(uint8 a, const uint8 *src) {
   }
 }
 
-// Perform initial parsing of the string, expanding words, processing some commands, etc.
-void Text_LoadCharacterBuffer() {  // 8ec4e2
+// Messages with the dictionary references and letters expanded into runs of
+// bytes, leaving only the commands that depend on the game state to handle
+// when a text box opens. A message is expanded the first time it's shown,
+// and ZeldaSetLanguage drops all of them.
+enum {
+  kTextRun_Bytes = 0,  // followed by a 16-bit length and the bytes
+  kTextRun_Cmd = 1,    // followed by the decoded 32-bit command
+  kTextRun_End = 2,
+};
+static uint8 **g_text_runs;
+static size_t g_text_runs_count;
+
+static void TextRuns_AppendBytes(ByteArray *arr, size_t *run_start, const uint8 *data, size_t size) {
+  if (*run_start == (size_t)-1 || arr->size - *run_start + size > 0xffff) {
+    uint8 hdr[3] = { kTextRun_Bytes, 0, 0 };
+    ByteArray_AppendData(arr, hdr, 3);
+    *run_start = arr->size;
+  }
+  ByteArray_AppendData(arr, data, size);
+  WORD(arr->data[*run_start - 2]) = arr->size - *run_start;
+}
+
+static uint8 *Text_ExpandMessage(int index) {
   MemBlk dictionary = FindIndexInMemblk(g_zenv.dialogue_blk, 0);
   MemBlk dialogue = FindIndexInMemblk(g_zenv.dialogue_blk, 1);
-  MemBlk text_str = FindIndexInMemblk(dialogue, dialogue_message_index);
-  const uint8 *src = text_str.ptr, *src_end = src + text_str.size, *src_org = src;
-  uint8 *dst = messaging_text_buffer;
+  MemBlk text_str = FindIndexInMemblk(dialogue, index);
+  const uint8 *src = text_str.ptr, *src_end = src + text_str.size;
+  ByteArray arr = { 0 };
+  size_t run_start = -1;
   while (src < src_end) {
     uint8 c = *src++;
     if (c >= kTextDictBase) {
       MemBlk blk = FindIndexInMemblk(dictionary, c - kTextDictBase);
-      memcpy(dst, blk.ptr, blk.size);
-      dst += blk.size;
+      TextRuns_AppendBytes(&arr, &run_start, blk.ptr, blk.size);
       continue;
     }
     // Decode the next byte or multibyte character (in case we support that in the future)
     // This is dependent on the current language cause US / PAL encode commands differently
     uint32 cmd = Text_DecodeCmd(c, src);
     switch (TEXTCMD_CMD(cmd)) {
+    case kTextCmd_Name:
+    case kTextCmd_Window:
+    case kTextCmd_Number:
+    case kTextCmd_Position:
+    case kTextCmd_Color: {
+      uint8 b[5] = { kTextRun_Cmd };
+      memcpy(b + 1, &cmd, 4);
+      ByteArray_AppendData(&arr, b, 5);
+      run_start = -1;
+      break;
+    }
+    default:
+      // This combination is handled when rendering instead of here
+      TextRuns_AppendBytes(&arr, &run_start, src - 1, 1 + TEXTCMD_MULTIBYTE(cmd));
+      break;
+    }
+    src += TEXTCMD_MULTIBYTE(cmd);
+  }
+  ByteArray_AppendByte(&arr, kTextRun_End);
+  return arr.data;
+}
+
+void Text_ClearMessageRuns() {
+  for (size_t i = 0; i < g_text_runs_count; i++)
+    free(g_text_runs[i]);
+  free(g_text_runs);
+  g_text_runs = NULL;
+  g_text_runs_count = 0;
+}
+
+static const uint8 *Text_GetMessageRuns(int index) {
+  if (index >= g_text_runs_count) {
+    size_t n = index + 1;
+    g_text_runs = realloc(g_text_runs, n * sizeof(uint8 *));
+    if (!g_text_runs)
+      Die("realloc failed");
+    memset(g_text_runs + g_text_runs_count, 0, (n - g_text_runs_count) * sizeof(uint8 *));
+    g_text_runs_count = n;
+  }
+  if (!g_text_runs[index])
+    g_text_runs[index] = Text_ExpandMessage(index);
+  return g_text_runs[index];
+}
+
+// Perform initial parsing of the string, expanding words, processing some commands, etc.
+void Text_LoadCharacterBuffer() {  // 8ec4e2
+  const uint8 *src = Text_GetMessageRuns(dialogue_message_index);
+  uint8 *dst = messaging_text_buffer;
+  for (;;) {
+    uint8 kind = *src++;
+    if (kind == kTextRun_End)
+      break;
+    if (kind == kTextRun_Bytes) {
+      uint16 n = WORD(src[0]);
+      memcpy(dst, src + 2, n);
+      dst += n;
+      src += 2 + n;
+      continue;
+    }
+    uint32 cmd;
+    memcpy(&cmd, src, 4);
+    src += 4;
+    switch (TEXTCMD_CMD(cmd)) {
     case kTextCmd_Name: dst = Text_WritePlayerName(dst); break;
     case kTextCmd_Window:  // RenderText_ExtendedCommand_SetWindowType
       text_render_state = TEXTCMD_PARAM(cmd);
@@ -2296,14 +2383,7 @@ void Text_LoadCharacterBuffer() {  // 8ec4e2
     case kTextCmd_Color:
       text_tilemap_cur = ((0x387F & 0xe300) | 0x180) | (TEXTCMD_PARAM(cmd) << 10) & 0x3c00;
       break;
-    default:
-      // This combination is handled when rendering instead of here
-      *dst++ = c;
-      if (TEXTCMD_MULTIBYTE(cmd))
-        *dst++ = *src;
-      break;
     }
-    src += TEXTCMD_MULTIBYTE(cmd);
   }
   *dst = 0x7f;
   dialogue_msg_read_pos = 0;
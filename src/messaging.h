@@ -99,6 +99,7 @@ void Text_Initialize();
 void Text_Initialize_initModuleStateLoop();
 void Text_InitVwfState();
 void Text_LoadCharacterBuffer();
+void Text_ClearMessageRuns();
 uint8 *Text_WritePlayerName(uint8 *p);
 uint8 Text_FilterPlayerNameCharacters(uint8 a);
 void Text_Render();
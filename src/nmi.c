@@ -47,18 +47,46 @@ void NMI_UploadSubscreenOverlayLatter() {
   NMI_HandleArbitraryTileMap(&g_ram[0x13000], 0x40, 0x80);
 }
 
-static void CopyToVram(uint32 dstv, const uint8 *src, int len) {
+// The uploads below all go through these, so that they end up in the vram journal.
+static void CopyToVram(uint32 dstv, const void *src, int len) {
+  VramJournal_Mark(dstv, (len + 1) >> 1);
   memcpy(&g_zenv.vram[dstv], src, len);
 }
 
+// With the vram address incrementing by 32, i.e. a column of a tilemap.
 static void CopyToVramVertical(uint32 dstv, const uint8 *src, int len) {
   assert(!(len & 1));
+  int num = len >> 1;
+  VramJournal_MarkVertical(dstv, num);
   uint16 *dst = &g_zenv.vram[dstv];
-  for (int i = 0, i_end = len >> 1; i < i_end; i++, dst += 32, src += 2)
+  // Read four words at once and scatter them down the column
+  for (; num >= 4; num -= 4, dst += 128, src += 8) {
+    uint64 v;
+    memcpy(&v, src, 8);
+    dst[0] = (uint16)v;
+    dst[32] = (uint16)(v >> 16);
+    dst[64] = (uint16)(v >> 32);
+    dst[96] = (uint16)(v >> 48);
+  }
+  for (; num; num--, dst += 32, src += 2)
     *dst = WORD(*src);
 }
 
+static void FillVram(uint32 dstv, uint16 v, int num, bool vertical) {
+  uint16 *dst = &g_zenv.vram[dstv];
+  if (vertical) {
+    VramJournal_MarkVertical(dstv, num);
+    for (int i = 0; i < num; i++, dst += 32)
+      *dst = v;
+  } else {
+    VramJournal_Mark(dstv, num);
+    for (int i = 0; i < num; i++)
+      dst[i] = v;
+  }
+}
+
 static void CopyToVramLow(const uint8 *src, uint32 addr, int num) {
+  VramJournal_Mark(addr, num);
   uint16 *dst = &g_zenv.vram[addr];
   for (int i = 0; i < num; i++)
     dst[i] = (dst[i] & ~0xff) | src[i];
@@ -171,41 +199,41 @@ void NMI_ReadJoypads(uint16 joypad_input) {  // 8083d1
 
 void NMI_DoUpdates() {  // 8089e0
   if (!nmi_disable_core_updates) {
-    memcpy(&g_zenv.vram[0x4100], &kLinkGraphics[dma_source_addr_0 - 0x8000], 0x40);
-    memcpy(&g_zenv.vram[0x4120], &kLinkGraphics[dma_source_addr_1 - 0x8000], 0x40);
-    memcpy(&g_zenv.vram[0x4140], &kLinkGraphics[dma_source_addr_2 - 0x8000], 0x20);
-
-    memcpy(&g_zenv.vram[0x4000], &kLinkGraphics[dma_source_addr_3 - 0x8000], 0x40);
-    memcpy(&g_zenv.vram[0x4020], &kLinkGraphics[dma_source_addr_4 - 0x8000], 0x40);
-    memcpy(&g_zenv.vram[0x4040], &kLinkGraphics[dma_source_addr_5 - 0x8000], 0x20);
-
-    memcpy(&g_zenv.vram[0x4050], &g_ram[dma_source_addr_6], 0x40);
-    memcpy(&g_zenv.vram[0x4070], &g_ram[dma_source_addr_7], 0x40);
-    memcpy(&g_zenv.vram[0x4090], &g_ram[dma_source_addr_8], 0x40);
-    memcpy(&g_zenv.vram[0x40b0], &g_ram[dma_source_addr_9], 0x20);
-    memcpy(&g_zenv.vram[0x40c0], &g_ram[dma_source_addr_10], 0x40);
-    memcpy(&g_zenv.vram[0x4150], &g_ram[dma_source_addr_11], 0x40);
-    memcpy(&g_zenv.vram[0x4170], &g_ram[dma_source_addr_12], 0x40);
-    memcpy(&g_zenv.vram[0x4190], &g_ram[dma_source_addr_13], 0x40);
-    memcpy(&g_zenv.vram[0x41b0], &g_ram[dma_source_addr_14], 0x20);
-    memcpy(&g_zenv.vram[0x41c0], &g_ram[dma_source_addr_15], 0x40);
-    memcpy(&g_zenv.vram[0x4200], &g_ram[dma_source_addr_16], 0x40);
-    memcpy(&g_zenv.vram[0x4220], &g_ram[dma_source_addr_17], 0x40);
-    memcpy(&g_zenv.vram[0x4240], &g_ram[0xbd40], 0x40);
-    memcpy(&g_zenv.vram[0x4300], &g_ram[dma_source_addr_18], 0x40);
-    memcpy(&g_zenv.vram[0x4320], &g_ram[dma_source_addr_19], 0x40);
-    memcpy(&g_zenv.vram[0x4340], &g_ram[0xbd80], 0x40);
+    CopyToVram(0x4100, &kLinkGraphics[dma_source_addr_0 - 0x8000], 0x40);
+    CopyToVram(0x4120, &kLinkGraphics[dma_source_addr_1 - 0x8000], 0x40);
+    CopyToVram(0x4140, &kLinkGraphics[dma_source_addr_2 - 0x8000], 0x20);
+
+    CopyToVram(0x4000, &kLinkGraphics[dma_source_addr_3 - 0x8000], 0x40);
+    CopyToVram(0x4020, &kLinkGraphics[dma_source_addr_4 - 0x8000], 0x40);
+    CopyToVram(0x4040, &kLinkGraphics[dma_source_addr_5 - 0x8000], 0x20);
+
+    CopyToVram(0x4050, &g_ram[dma_source_addr_6], 0x40);
+    CopyToVram(0x4070, &g_ram[dma_source_addr_7], 0x40);
+    CopyToVram(0x4090, &g_ram[dma_source_addr_8], 0x40);
+    CopyToVram(0x40b0, &g_ram[dma_source_addr_9], 0x20);
+    CopyToVram(0x40c0, &g_ram[dma_source_addr_10], 0x40);
+    CopyToVram(0x4150, &g_ram[dma_source_addr_11], 0x40);
+    CopyToVram(0x4170, &g_ram[dma_source_addr_12], 0x40);
+    CopyToVram(0x4190, &g_ram[dma_source_addr_13], 0x40);
+    CopyToVram(0x41b0, &g_ram[dma_source_addr_14], 0x20);
+    CopyToVram(0x41c0, &g_ram[dma_source_addr_15], 0x40);
+    CopyToVram(0x4200, &g_ram[dma_source_addr_16], 0x40);
+    CopyToVram(0x4220, &g_ram[dma_source_addr_17], 0x40);
+    CopyToVram(0x4240, &g_ram[0xbd40], 0x40);
+    CopyToVram(0x4300, &g_ram[dma_source_addr_18], 0x40);
+    CopyToVram(0x4320, &g_ram[dma_source_addr_19], 0x40);
+    CopyToVram(0x4340, &g_ram[0xbd80], 0x40);
 
     if (BYTE(flag_travel_bird)) {
-      memcpy(&g_zenv.vram[0x40e0], &g_ram[dma_source_addr_20], 0x40);
-      memcpy(&g_zenv.vram[0x41e0], &g_ram[dma_source_addr_21], 0x40);
+      CopyToVram(0x40e0, &g_ram[dma_source_addr_20], 0x40);
+      CopyToVram(0x41e0, &g_ram[dma_source_addr_21], 0x40);
     }
 
-    memcpy(&g_zenv.vram[animated_tile_vram_addr], &g_ram[animated_tile_data_src], 0x400);
+    CopyToVram(animated_tile_vram_addr, &g_ram[animated_tile_data_src], 0x400);
   }
 
   if (flag_update_hud_in_nmi) {
-    memcpy(&g_zenv.vram[word_7E0219], hud_tile_indices_buffer, 165 * sizeof(uint16));
+    CopyToVram(word_7E0219, hud_tile_indices_buffer, 165 * sizeof(uint16));
   }
 
   if (flag_update_cgram_in_nmi) {
@@ -216,6 +244,7 @@ void NMI_DoUpdates() {  // 8089e0
   flag_update_cgram_in_nmi = 0;
 
   memcpy(g_zenv.ppu->oam, &g_ram[0x800], 0x220);
+  g_zenv.ppu->oamLiveDirty = true;
 
   if (nmi_load_bg_from_vram) {
     const uint8 *p;
@@ -238,7 +267,7 @@ void NMI_DoUpdates() {  // 8089e0
   }
 
   if (nmi_update_tilemap_dst) {
-    memcpy(&g_zenv.vram[nmi_update_tilemap_dst * 256], &g_ram[0x10000 + nmi_update_tilemap_src], 0x200);
+    CopyToVram(nmi_update_tilemap_dst * 256, &g_ram[0x10000 + nmi_update_tilemap_src], 0x200);
     nmi_update_tilemap_dst = 0;
   }
 
@@ -251,13 +280,10 @@ void NMI_DoUpdates() {  // 8089e0
       p += 4;
       if (vmain == 0x80) {
         // plain copy
-        memcpy(&g_zenv.vram[dst], p, len);
+        CopyToVram(dst, p, len);
       } else if (vmain == 0x81) {
         // copy with other increment
-        assert((len & 1) == 0);
-        uint16 *dp = &g_zenv.vram[dst];
-        for (int i = 0; i < len; i += 2, dp += 32)
-          *dp = WORD(p[i]);
+        CopyToVramVertical(dst, p, len);
       } else {
         assert(0);
       }
@@ -273,7 +299,7 @@ void NMI_DoUpdates() {  // 8089e0
 }
 
 void NMI_UploadTilemap() {  // 808cb0
-  memcpy(&g_zenv.vram[kNmiVramAddrs[BYTE(nmi_load_target_addr)] << 8], &g_ram[0x1000], 0x800);
+  CopyToVram(kNmiVramAddrs[BYTE(nmi_load_target_addr)] << 8, &g_ram[0x1000], 0x800);
 
   *(uint16 *)&g_ram[0x1000] = 0;
   nmi_disable_core_updates = 0;
@@ -283,21 +309,21 @@ void NMI_UploadTilemap_doNothing() {  // 808ce3
 }
 
 void NMI_UploadBG3Text() {  // 808ce4
-  memcpy(&g_zenv.vram[0x7c00], &g_ram[0x10000], 0x7e0);
+  CopyToVram(0x7c00, &g_ram[0x10000], 0x7e0);
   nmi_disable_core_updates = 0;
 }
 
 void NMI_UpdateOWScroll() {  // 808d13
   uint8 *src = (uint8 *)uvram.data;
   int f = WORD(src[0]);
-  int step = (f & 0x8000) ? 32 : 1;
-  int len = f & 0x3fff;
+  int len = f & 0x3ffe;
   src += 2;
   do {
-    uint16 *dst = &g_zenv.vram[WORD(src[0])];
-    src += 2;
-    for (int i = 0, i_end = len >> 1; i < i_end; i++, dst += step, src += 2)
-      *dst = WORD(*src);
+    if (f & 0x8000)
+      CopyToVramVertical(WORD(src[0]), src + 2, len);
+    else
+      CopyToVram(WORD(src[0]), src + 2, len);
+    src += 2 + len;
   } while (!(src[1] & 0x80));
   nmi_disable_core_updates = 0;
 }
@@ -309,7 +335,7 @@ void NMI_UpdateSubscreenOverlay() {  // 808d62
 void NMI_HandleArbitraryTileMap(const uint8 *src, int i, int i_end) {  // 808dae
   uint16 *r10 = &word_7F4000;
   do {
-    memcpy(&g_zenv.vram[r10[i >> 1]], src, 0x80);
+    CopyToVram(r10[i >> 1], src, 0x80);
     src += 0x80;
   } while ((i += 2) != i_end);
   nmi_disable_core_updates = 0;
@@ -343,17 +369,17 @@ void NMI_UpdateBG2Left() {  // 808ea9
 }
 
 void NMI_UpdateBGChar3and4() {  // 808ee7
-  memcpy(&g_zenv.vram[0x2c00], &g_ram[0x10000], 0x1000);
+  CopyToVram(0x2c00, &g_ram[0x10000], 0x1000);
   nmi_disable_core_updates = 0;
 }
 
 void NMI_UpdateBGChar5and6() {  // 808f16
-  memcpy(&g_zenv.vram[0x3400], &g_ram[0x11000], 0x1000);
+  CopyToVram(0x3400, &g_ram[0x11000], 0x1000);
   nmi_disable_core_updates = 0;
 }
 
 void NMI_UpdateBGCharHalf() {  // 808f45
-  memcpy(&g_zenv.vram[BYTE(nmi_load_target_addr) * 256], &g_ram[0x11000], 0x400);
+  CopyToVram(BYTE(nmi_load_target_addr) * 256, &g_ram[0x11000], 0x400);
 }
 
 void NMI_UpdateBGChar0() {  // 808f72
@@ -421,40 +447,23 @@ void HandleStripes14(const uint8 *p) {  // 8092a1
     int len = (swap16(WORD(p[2])) & 0x3fff) + 1;
     p += 4;
 
-    if (vram_incr_amount == 0) {
-      uint16 *dst = &g_zenv.vram[vmem_addr];
-      if (is_memset) {
-        uint16 v = p[0] | p[1] << 8;
-        len = (len + 1) >> 1;
-        for (int i = 0; i < len; i++)
-          dst[i] = v;
-        p += 2;
-      } else {
-        memcpy(dst, p, len);
-        p += len;
-      }
+    // vram_incr_amount means increment vram by 32 instead of 1
+    if (is_memset) {
+      FillVram(vmem_addr, p[0] | p[1] << 8, (len + 1) >> 1, vram_incr_amount != 0);
+      p += 2;
+    } else if (vram_incr_amount == 0) {
+      CopyToVram(vmem_addr, p, len);
+      p += len;
     } else {
-      // increment vram by 32 instead of 1
-      uint16 *dst = &g_zenv.vram[vmem_addr];
-      if (is_memset) {
-        uint16 v = p[0] | p[1] << 8;
-        len = (len + 1) >> 1;
-        for (int i = 0; i < len; i++, dst += 32)
-          *dst = v;
-        p += 2;
-      } else {
-        assert((len & 1) == 0);
-        len >>= 1;
-        for (int i = 0; i < len; i++, dst += 32, p += 2)
-          WORD(*dst) = WORD(*p);
-      }
+      CopyToVramVertical(vmem_addr, p, len);
+      p += len;
     }
   }
 }
 
 void NMI_UpdateIRQGFX() {  // 809347
   if (nmi_flag_update_polyhedral) {
-    memcpy(&g_zenv.vram[0x5800], &g_ram[0xe800], 0x800);
+    CopyToVram(0x5800, &g_ram[0xe800], 0x800);
     nmi_flag_update_polyhedral = 0;
   }
 }
@@ -11,6 +11,8 @@
 #include "player_oam.h"
 #include "snes/snes_regs.h"
 #include "assets.h"
+#include "util.h"
+#include "map8_stripe.h"
 
 const uint16 kOverworld_OffsetBaseX[64] = {
   0,     0, 0x400, 0x600, 0x600, 0xa00, 0xa00, 0xe00,
@@ -2385,26 +2387,15 @@ uint16 *BufferAndBuildMap16Stripes_X(uint16 *dst) {  // 82f3b9
     tmp[d] = (pos >= 0x2000) ? 0 : dung_bg2[pos >> 1];
     d = (d + 1) & 0x1f, pos += 128;
   }
-  const uint16 *map8 = GetMap16toMap8Table();
   uint16 r0 = 0, of = map16_load_dst_off;
   if (of >= 0x10)
     of &= 0xf, r0 = 0x400;
   r0 += of * 2;
-  for (int i = 0; i < 2; i++, r0 += 0x800) {
+  for (int i = 0; i < 2; i++, r0 += 0x800, tmp += 16) {
     dst[0] = r0;
     dst[33] = r0 + 1;
-    dst++;
-    for (int j = 0; j < 16; j++) {
-      int k = *tmp++;
-      assert(k < 0xea8);
-      const uint16 *s = map8 + k * 4;
-      dst[0] = s[0];
-      dst[33] = s[1];
-      dst[1] = s[2];
-      dst[34] = s[3];
-      dst += 2;
-    }
-    dst += 33;
+    BuildMap8Stripe(dst + 1, dst + 34, GetMap16toMap8Table(), tmp, 16, true);
+    dst += 66;
   }
   return dst;
 }
@@ -2418,24 +2409,14 @@ uint16 *BufferAndBuildMap16Stripes_Y(uint16 *dst) {  // 82f482
     pos += 2;
     d = (d + 1) & 0x1f;
   }
-  const uint16 *map8 = GetMap16toMap8Table();
   uint16 r0 = 0, of = map16_load_var2;
   if (of >= 0x10)
     of &= 0xf, r0 = 0x800;
   r0 += of * 64;
-  for (int i = 0; i < 2; i++, r0 += 0x400) {
-    *dst++ = r0;
-    for (int j = 0; j < 16; j++) {
-      int k = *tmp++;
-      assert(k < 0xea8);
-      const uint16 *s = map8 + k * 4;
-      dst[0] = s[0];
-      dst[32] = s[2];
-      dst[1] = s[1];
-      dst[33] = s[3];
-      dst += 2;
-    }
-    dst += 32;
+  for (int i = 0; i < 2; i++, r0 += 0x400, tmp += 16) {
+    dst[0] = r0;
+    BuildMap8Stripe(dst + 1, dst + 33, GetMap16toMap8Table(), tmp, 16, false);
+    dst += 65;
   }
   return dst;
 }
@@ -2448,27 +2429,50 @@ void Overworld_DecompressAndDrawAllQuadrants() {  // 82f54a
   Overworld_DecompressAndDrawOneQuadrant((uint16 *)&g_ram[0x3040], si + 9);
 }
 
-static const uint8 *GetOverworldHibytes(int i) {
-  return kOverworld_Hibytes_Comp(i).ptr;
+static MemBlk GetOverworldHibytes(int i) {
+  return kOverworld_Hibytes_Comp(i);
 }
 
-static const uint8 *GetOverworldLobytes(int i) {
-  return kOverworld_Lobytes_Comp(i).ptr;
+static MemBlk GetOverworldLobytes(int i) {
+  return kOverworld_Lobytes_Comp(i);
 }
 
 
+// A quadrant only depends on the screen, so what it decodes to is kept per
+// screen. Changed map16 tiles are put back by the callers after drawing, so
+// they are never part of this. The scratch ram the decoding leaves behind is
+// kept too, so that ram looks the same on a hit.
+typedef struct OverworldQuadrant {
+  uint16 map16[32][32];
+  uint16 map32[256];
+  uint16 scratch_len;
+  uint8 scratch[0x400];
+} OverworldQuadrant;
+
+static OverworldQuadrant *g_overworld_quadrants[256];
+
 void Overworld_DecompressAndDrawOneQuadrant(uint16 *dst, int screen) {  // 82f595
-  Decompress_bank02(&g_ram[0x14400], GetOverworldHibytes(screen));
+  OverworldQuadrant *q = (screen >= 0 && screen < 256) ? g_overworld_quadrants[screen] : NULL;
+  if (q) {
+    memcpy(&g_ram[0x14000], q->map32, sizeof(q->map32));
+    memcpy(&g_ram[0x14400], q->scratch, q->scratch_len);
+    for (int j = 0; j < 32; j++)
+      memcpy(dst + j * 64, q->map16[j], sizeof(q->map16[j]));
+    return;
+  }
+
+  int hi_len = Decompress_bank02(&g_ram[0x14400], GetOverworldHibytes(screen));
   for (int i = 0; i < 256; i++)
     g_ram[0x14001 + i * 2] = g_ram[0x14400 + i];
 
-  Decompress_bank02(&g_ram[0x14400], GetOverworldLobytes(screen));
+  int lo_len = Decompress_bank02(&g_ram[0x14400], GetOverworldLobytes(screen));
   for (int i = 0; i < 256; i++)
     g_ram[0x14000 + i * 2] = g_ram[0x14400 + i];
 
   map16_decode_last = 0xffff;
 
   uint16 *src = (uint16 *)&g_ram[0x14000];
+  uint16 *dst_org = dst;
   for (int j = 0; j < 16; j++) {
     for (int i = 0; i < 16; i++) {
       Overworld_ParseMap32Definition(dst, *src++ * 2);
@@ -2476,6 +2480,19 @@ void Overworld_DecompressAndDrawOneQuadrant(uint16 *dst, int screen) {  // 82f59
     }
     dst += 96;
   }
+
+  int scratch_len = IntMax(IntMax(hi_len, lo_len), 0x44);
+  if (screen < 0 || screen >= 256 || scratch_len > sizeof(q->scratch))
+    return;
+  q = malloc(sizeof(OverworldQuadrant));
+  if (!q)
+    return;
+  memcpy(q->map32, &g_ram[0x14000], sizeof(q->map32));
+  q->scratch_len = scratch_len;
+  memcpy(q->scratch, &g_ram[0x14400], scratch_len);
+  for (int j = 0; j < 32; j++)
+    memcpy(q->map16[j], dst_org + j * 64, sizeof(q->map16[j]));
+  g_overworld_quadrants[screen] = q;
 }
 
 void Overworld_ParseMap32Definition(uint16 *dst, uint16 input) {  // 82f691
@@ -2555,8 +2572,6 @@ void Map16ToMap8(const uint8 *src, int r20) {  // 82fd46
 }
 
 void OverworldCopyMap16ToBuffer(const uint8 *src, uint16 r20, int r14, uint16 *r10) {  // 82fd87
-  const uint16 *map8 = GetMap16toMap8Table();
-
   int yr = map16_load_src_off - 0x410 & 0x1fff;
   int xr = map16_load_dst_off;
   uint16 *tmp = (uint16 *)(g_ram + 0x500);
@@ -2572,15 +2587,10 @@ void OverworldCopyMap16ToBuffer(const uint8 *src, uint16 r20, int r14, uint16 *r
     of &= 0xf, r0 = 0x800;
   r0 += of * 64;
 
-  for (int i = 0; i < 2; i++, r0 += 0x400, r14 += 0x40) {
+  for (int i = 0; i < 2; i++, r0 += 0x400, r14 += 0x80, tmp += 16) {
     *r10++ = r0 | r20;
-    for (int j = 0; j < 16; j++, r14 += 4) {
-      const uint16 *m = map8 + 4 * *tmp++;
-      WORD(dung_bg2_attr_table[r14]) = WORD(m[0]);
-      WORD(dung_bg2_attr_table[r14 + 64]) = WORD(m[2]);
-      WORD(dung_bg2_attr_table[r14 + 2]) = WORD(m[1]);
-      WORD(dung_bg2_attr_table[r14 + 66]) = WORD(m[3]);
-    }
+    uint16 *row = (uint16 *)&dung_bg2_attr_table[r14];
+    BuildMap8Stripe(row, row + 32, GetMap16toMap8Table(), tmp, 16, false);
   }
 
 }
@@ -2602,54 +2612,8 @@ void DecompressEnemyDamageSubclasses() {  // 82fe71
   }
 }
 
-int Decompress_bank02(uint8 *dst, const uint8 *src) {  // 82febb
-  uint8 *dst_org = dst;
-  int len;
-  for (;;) {
-    uint8 cmd = *src++;
-    if (cmd == 0xff)
-      return dst - dst_org;
-    if ((cmd & 0xe0) != 0xe0) {
-      len = (cmd & 0x1f) + 1;
-      cmd &= 0xe0;
-    } else {
-      len = *src++;
-      len += ((cmd & 3) << 8) + 1;
-      cmd = (cmd << 3) & 0xe0;
-    }
-    //printf("%d: %d,%d\n", (int)(dst - dst_org), cmd, len);
-    if (cmd == 0) {
-      do {
-        *dst++ = *src++;
-      } while (--len);
-    } else if (cmd & 0x80) {
-      uint32 offs = *src++ << 8;
-      offs |= *src++;
-      do {
-        *dst++ = dst_org[offs++];
-      } while (--len);
-    } else if (!(cmd & 0x40)) {
-      uint8 v = *src++;
-      do {
-        *dst++ = v;
-      } while (--len);
-    } else if (!(cmd & 0x20)) {
-      uint8 lo = *src++;
-      uint8 hi = *src++;
-      do {
-        *dst++ = lo;
-        if (--len == 0)
-          break;
-        *dst++ = hi;
-      } while (--len);
-    } else {
-      // copy bytes with the byte incrementing by 1 in between
-      uint8 v = *src++;
-      do {
-        *dst++ = v;
-      } while (v++, --len);
-    }
-  }
+int Decompress_bank02(uint8 *dst, MemBlk src) {  // 82febb
+  return DecompressLz(dst, src, true);
 }
 
 uint8 Overworld_ReadTileAttribute(uint16 x, uint16 y) {  // 85faa2
@@ -47,9 +47,6 @@ static void ProcessGamepadInput();
 
 /* ========== Static Data ========== */
 
-const uint8 *g_asset_ptrs[kNumberOfAssets];
-uint32 g_asset_sizes[kNumberOfAssets];
-
 static uint8 g_paused, g_turbo, g_replay_turbo = true, g_cursor = true;
 static uint8 g_current_window_scale;
 static uint8 g_gamepad_buttons;
@@ -151,6 +148,7 @@ int main(int argc, char** argv)
 
     // Set the language
     ZeldaSetLanguage(g_config.language);
+    ZeldaSetGfxSheetCacheSize(g_config.gfx_sheet_cache);
 
     // TODO: Audio setup
 
@@ -241,27 +239,9 @@ static void LoadAssets() {
         Die("Failed to read zelda3_assets.dat. Please see the README for information about how you get this file.");
     }
 
-    static const char kAssetsSig[] = { kAssets_Sig };
-
-    if (length < 16 + 32 + 32 + 8 + kNumberOfAssets * 4 ||
-        memcmp(data, kAssetsSig, 48) != 0 ||
-        *(uint32*)(data + 80) != kNumberOfAssets
-    ) {
-        Die("Invalid assets file");
-    }
-
-    uint32 offset = 88 + kNumberOfAssets * 4 + *(uint32 *)(data + 84);
-
-    for (size_t i = 0; i < kNumberOfAssets; i++) {
-        uint32 size = *(uint32 *)(data + 88 + i * 4);
-        offset = (offset + 3) & ~3;
-        if ((uint64)offset + size > length) {
-            Die("Assets file corruption");
-        }
-        g_asset_sizes[i] = size;
-        g_asset_ptrs[i] = data + offset;
-        offset += size;
-    }
+    // Assets stored with restool --on-demand-assets stay compressed in this
+    // buffer until they are used.
+    LoadAssetsFromMemory(data, length);
 
     // Patch dungeon floor palettes
     if (g_config.features0 & kFeatures0_DimFlashes) {
@@ -320,11 +300,6 @@ static void LoadLinkGraphics() {
     }
 }
 
-/** Find a specific asset in the asset array. */
-MemBlk FindInAssetArray(int asset, int idx) {
-    return FindIndexInMemblk((MemBlk) { g_asset_ptrs[asset], g_asset_sizes[asset] }, idx);
-}
-
 /** Draw a full frame, and optionally the frame rate as well. */
 static void DrawPpuFrameWithPerf() {
     int render_scale = PpuGetCurrentRenderScale(g_zenv.ppu, g_ppu_render_flags);
@@ -172,6 +172,7 @@ void LoadFileSelectGraphics() {  // 80e4e9
   TransferFontToVRAM();
 
   Decomp_spr(&g_ram[0x14000], 0x6b);
+  VramJournal_Mark(0x7800, 0x300);
   memcpy(&g_zenv.vram[0x7800], &g_ram[0x14000], 0x300 * sizeof(uint16));
 }
 
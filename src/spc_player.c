@@ -1237,8 +1237,12 @@ void SpcPlayer_GenerateSamples(SpcPlayer *p) {
 
     p->timer_cycles += n;
 
-    for (int i = 0; i < n; i++)
-      dsp_cycle(p->dsp);
+    // Menus and quiet rooms often have all voices released, in which case
+    // the whole chunk can be skipped over.
+    if (!dsp_cycleIdle(p->dsp, n)) {
+      for (int i = 0; i < n; i++)
+        dsp_cycle(p->dsp);
+    }
 
     if (p->dsp->sampleOffset == 534)
       break;
@@ -1260,6 +1264,7 @@ void SpcPlayer_Upload(SpcPlayer *p, const uint8_t *data) {
       p->ram[target++ & 0xffff] = *data++;
     } while (--numbytes);
   }
+  dsp_invalidateEcho(p->dsp);
   p->pause_music_ctr = 0;
   p->port_to_snes[0] = 0;
   p->port1_active = 0;
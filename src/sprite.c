@@ -1107,6 +1107,58 @@ void Sprite_SpawnSecret(int k) {  // 868264
   }
 }
 
+// The cost of each sprite type's logic, collected while a clock is set with
+// Sprite_EnableProfiling, to find the types worth optimizing.
+typedef struct SpriteProfileEntry {
+  uint64 ticks;
+  uint32 calls;
+} SpriteProfileEntry;
+static SpriteProfileEntry g_sprite_profile[256];
+static SpriteProfileClockFunc *g_sprite_profile_clock;
+static uint64 g_sprite_profile_freq;
+static uint32 g_sprite_profile_frames;
+
+void Sprite_EnableProfiling(SpriteProfileClockFunc *clock, uint64 freq) {
+  g_sprite_profile_clock = clock;
+  g_sprite_profile_freq = freq;
+  g_sprite_profile_frames = 0;
+  memset(g_sprite_profile, 0, sizeof(g_sprite_profile));
+}
+
+static void Sprite_ExecuteSingleProfiled(int k) {
+  // Charge it to the type it had when it started, as a sprite may replace itself.
+  SpriteProfileEntry *e = &g_sprite_profile[sprite_type[k]];
+  uint64 before = g_sprite_profile_clock();
+  Sprite_ExecuteSingle(k);
+  e->ticks += g_sprite_profile_clock() - before;
+  e->calls++;
+}
+
+// Prints the most expensive sprite types since the last call, and starts over.
+void Sprite_PrintProfile() {
+  if (!g_sprite_profile_clock || !g_sprite_profile_frames)
+    return;
+  uint8 order[256];
+  int n = 0;
+  for (int i = 0; i < 256; i++) {
+    if (!g_sprite_profile[i].calls)
+      continue;
+    int j = n++;
+    for (; j > 0 && g_sprite_profile[order[j - 1]].ticks < g_sprite_profile[i].ticks; j--)
+      order[j] = order[j - 1];
+    order[j] = i;
+  }
+  double us_per_tick = 1e6 / g_sprite_profile_freq;
+  fprintf(stderr, "Sprite cost over %u frames:\n", g_sprite_profile_frames);
+  for (int i = 0; i < n && i < 12; i++) {
+    SpriteProfileEntry *e = &g_sprite_profile[order[i]];
+    fprintf(stderr, "  type %.2x: %7u calls, %7.2f us/frame, %6.2f us/call\n", order[i], e->calls,
+            e->ticks * us_per_tick / g_sprite_profile_frames, e->ticks * us_per_tick / e->calls);
+  }
+  g_sprite_profile_frames = 0;
+  memset(g_sprite_profile, 0, sizeof(g_sprite_profile));
+}
+
 void Sprite_Main() {  // 868328
   if (!player_is_indoors) {
     ancilla_floor[0] = 0;
@@ -1138,9 +1190,14 @@ void Sprite_Main() {  // 868328
   Ancilla_Main();
   Overlord_Main();
   archery_game_out_of_arrows = 0;
+  if (g_sprite_profile_clock)
+    g_sprite_profile_frames++;
   for (int i = 15; i >= 0; i--) {
     cur_object_index = i;
-    Sprite_ExecuteSingle(i);
+    if (g_sprite_profile_clock && sprite_state[i])
+      Sprite_ExecuteSingleProfiled(i);
+    else
+      Sprite_ExecuteSingle(i);
   }
   Garnish_ExecuteLowerSlots();
   byte_7E069E[0] = byte_7E069E[1] = 0;
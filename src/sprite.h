@@ -113,6 +113,9 @@ void Sprite_SpawnImmediatelySmashedTerrain(uint8 what, uint16 x, uint16 y);
 void Sprite_SpawnThrowableTerrain(uint8 what, uint16 x, uint16 y);
 int Sprite_SpawnThrowableTerrain_silently(uint8 what, uint16 x, uint16 y);
 void Sprite_SpawnSecret(int k);
+typedef uint64 SpriteProfileClockFunc();
+void Sprite_EnableProfiling(SpriteProfileClockFunc *clock, uint64 freq);
+void Sprite_PrintProfile();
 void Sprite_Main();
 void Oam_ResetRegionBases();
 void Sprite_TimersAndOam(int k);
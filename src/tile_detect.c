@@ -3,6 +3,7 @@
 #include "ancilla.h"
 #include "variables.h"
 #include "overworld.h"
+#include "assets.h"
 
 static const uint8 kDetectTiles_tab0[] = { 8, 24, 0, 15 };
 static const uint8 kDetectTiles_tab1[] = { 0, 0, 8, 8 };
@@ -11,16 +12,7 @@ static const uint8 kDetectTiles_tab3[] = { 15, 15, 23, 23 };
 static const int8 kDetectTiles_tab4[] = { 7, 24, -1, 16 };
 static const uint8 kDetectTiles_tab5[] = { 0, 0, 8, 8 };
 static const uint8 kDetectTiles_tab6[] = { 15, 15, 23, 23 };
-uint8 Overworld_GetTileAttributeAtLocation(uint16 x, uint16 y) {  // 80882e
-  uint16 t;
-
-  t = ((y - overworld_offset_base_y) & overworld_offset_mask_y) * 8;
-  t |= ((x - overworld_offset_base_x) & overworld_offset_mask_x);
-  t = overworld_tileattr[t >> 1] * 4;
-  t |= (y & 8) >> 2;
-  t |= (x & 1);
-  t = GetMap16toMap8Table()[t];
-
+static uint8 Map8ToTileAttr(uint16 t) {
   uint8 rv = GetMap8toTileAttr()[t & 0x1ff];
   if (rv >= 0x10 && rv < 0x1C) {
     rv |= (t >> 14) & 1;
@@ -28,6 +20,36 @@ uint8 Overworld_GetTileAttributeAtLocation(uint16 x, uint16 y) {  // 80882e
   return rv;
 }
 
+// The attributes of the four 8x8 parts of every map16 tile, so a probe is
+// a single lookup by the map16 tile at its location. Changed map16 tiles are
+// picked up by that lookup, so this never needs rebuilding.
+static uint8 *g_map16_tile_attr;
+static uint32 g_map16_tile_attr_count;
+
+static void BuildMap16TileAttr() {
+  g_map16_tile_attr_count = kMap8DataToTileAttr_SIZE >= 0x200 ? kMap16ToMap8_SIZE / 8 : 0;
+  g_map16_tile_attr = malloc(g_map16_tile_attr_count * 4 + 1);
+  if (!g_map16_tile_attr)
+    Die("malloc failed");
+  const uint16 *map8 = GetMap16toMap8Table();
+  for (uint32 i = 0; i < g_map16_tile_attr_count * 4; i++)
+    g_map16_tile_attr[i] = Map8ToTileAttr(map8[i]);
+}
+
+uint8 Overworld_GetTileAttributeAtLocation(uint16 x, uint16 y) {  // 80882e
+  uint16 t;
+
+  t = ((y - overworld_offset_base_y) & overworld_offset_mask_y) * 8;
+  t |= ((x - overworld_offset_base_x) & overworld_offset_mask_x);
+  uint16 m = overworld_tileattr[t >> 1];
+  int part = (y & 8) >> 2 | (x & 1);
+  if (!g_map16_tile_attr)
+    BuildMap16TileAttr();
+  if (m < g_map16_tile_attr_count)
+    return g_map16_tile_attr[m * 4 + part];
+  return Map8ToTileAttr(GetMap16toMap8Table()[(uint16)(m * 4 + part)]);
+}
+
 void TileDetect_Movement_Y(uint16 direction) {  // 87cdcb
   assert(direction < 4);
   TileDetect_ResetState();
@@ -1,3 +1,14 @@
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#define HAVE_MAP_WHOLE_FILE 1
+#elif (defined(__unix__) || defined(__APPLE__)) && !defined(__3DS__) && !defined(__SWITCH__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HAVE_MAP_WHOLE_FILE 1
+#endif
 #include "util.h"
 #include <stdio.h>
 #include <string.h>
@@ -56,6 +67,57 @@ uint8 *ReadWholeFile(const char *name, size_t *length) {
   return buffer;
 }
 
+// Maps a file read-only into memory, or with |copy_on_write| so that writes
+// go to private copies of the touched pages and never reach the file. Returns
+// NULL if the file can't be opened, is empty, or the platform has no file
+// mappings, in which case the caller should fall back to regular reads.
+uint8 *MapWholeFile(const char *name, size_t *length, bool copy_on_write) {
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return NULL;
+  LARGE_INTEGER size;
+  void *view = NULL;
+  if (GetFileSizeEx(file, &size) && size.QuadPart != 0 && (uint64)size.QuadPart <= (size_t)-1) {
+    // The view keeps the mapping alive, so both handles can be closed now.
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping) {
+      view = MapViewOfFile(mapping, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+      CloseHandle(mapping);
+    }
+  }
+  CloseHandle(file);
+  if (view && length) *length = (size_t)size.QuadPart;
+  return (uint8 *)view;
+#elif defined(HAVE_MAP_WHOLE_FILE)
+  int fd = open(name, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  void *view = NULL;
+  if (fstat(fd, &st) == 0 && st.st_size != 0) {
+    view = mmap(NULL, st.st_size, copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED)
+      view = NULL;
+  }
+  close(fd);
+  if (view && length) *length = st.st_size;
+  return (uint8 *)view;
+#else
+  return NULL;
+#endif
+}
+
+void UnmapWholeFile(const uint8 *data, size_t length) {
+  if (!data)
+    return;
+#if defined(_WIN32)
+  UnmapViewOfFile(data);
+#elif defined(HAVE_MAP_WHOLE_FILE)
+  munmap((void *)data, length);
+#endif
+}
+
 char *NextLineStripComments(char **s) {
   char *p = *s;
   if (p == NULL)
@@ -171,6 +233,73 @@ void ByteArray_AppendByte(ByteArray *arr, uint8 v) {
   arr->data[arr->size - 1] = v;
 }
 
+// Decoder for the LZ format of the graphics sheets and overworld maps. Back
+// references are little endian in bank 00 and big endian in bank 02. Runs
+// are written with memcpy and memset, except back references that overlap
+// the bytes being written, as those repeat a pattern and go byte by byte.
+int DecompressLz(uint8 *dst, MemBlk src, bool big_endian_offs) {
+  uint8 *dst_org = dst;
+  const uint8 *s = src.ptr, *s_end = src.ptr + src.size;
+  while (s != s_end) {
+    uint8 cmd = *s++;
+    if (cmd == 0xff)
+      return dst - dst_org;
+    int len;
+    if ((cmd & 0xe0) != 0xe0) {
+      len = (cmd & 0x1f) + 1;
+      cmd &= 0xe0;
+    } else {
+      if (s == s_end)
+        break;
+      len = *s++ + ((cmd & 3) << 8) + 1;
+      cmd = (cmd << 3) & 0xe0;
+    }
+    if (cmd == 0) {
+      if (s_end - s < len)
+        break;
+      memcpy(dst, s, len);
+      s += len, dst += len;
+    } else if (cmd & 0x80) {
+      if (s_end - s < 2)
+        break;
+      const uint8 *from = dst_org + (big_endian_offs ? s[0] << 8 | s[1] : s[0] | s[1] << 8);
+      s += 2;
+      if (from + len <= dst || from >= dst + len) {
+        memcpy(dst, from, len);
+        dst += len;
+      } else {
+        do {
+          *dst++ = *from++;
+        } while (--len);
+      }
+    } else if (!(cmd & 0x40)) {
+      if (s == s_end)
+        break;
+      memset(dst, *s++, len);
+      dst += len;
+    } else if (!(cmd & 0x20)) {
+      if (s_end - s < 2)
+        break;
+      uint8 lo = s[0], hi = s[1];
+      s += 2;
+      for (; len >= 2; len -= 2, dst += 2)
+        dst[0] = lo, dst[1] = hi;
+      if (len)
+        *dst++ = lo;
+    } else {
+      // copy bytes with the byte incrementing by 1 in between
+      if (s == s_end)
+        break;
+      uint8 v = *s++;
+      do {
+        *dst++ = v++;
+      } while (--len);
+    }
+  }
+  Die("Compressed data is truncated");
+  return 0;
+}
+
 // Automatically selects between 16 or 32 bit indexes. Can hold up to 8192 elements in 16-bit mode.
 MemBlk FindIndexInMemblk(MemBlk data, size_t i) {
   if (data.size < 2)
@@ -277,4 +406,20 @@ uint8 *ApplyBps(const uint8 *src, size_t src_size_in,
   if (crc32(dst, dst_size) != *(uint32 *)(bps_end + 4))
     return NULL;
   return dst;
+}
+
+void MakeWavHeader(uint8 *hdr, int freq, int channels, uint32 num_frames) {
+  uint32 data_size = num_frames * channels * 2;
+  memcpy(hdr, "RIFF", 4);
+  *(uint32 *)(hdr + 4) = 36 + data_size;
+  memcpy(hdr + 8, "WAVEfmt ", 8);
+  *(uint32 *)(hdr + 16) = 16;
+  *(uint16 *)(hdr + 20) = 1;  // pcm
+  *(uint16 *)(hdr + 22) = channels;
+  *(uint32 *)(hdr + 24) = freq;
+  *(uint32 *)(hdr + 28) = freq * channels * 2;
+  *(uint16 *)(hdr + 32) = channels * 2;
+  *(uint16 *)(hdr + 34) = 16;
+  memcpy(hdr + 36, "data", 4);
+  *(uint32 *)(hdr + 40) = data_size;
 }
\ No newline at end of file
@@ -24,6 +24,8 @@ void ByteArray_AppendData(ByteArray *arr, const uint8 *data, size_t data_size);
 void ByteArray_AppendByte(ByteArray *arr, uint8 v);
 
 uint8 *ReadWholeFile(const char *name, size_t *length);
+uint8 *MapWholeFile(const char *name, size_t *length, bool copy_on_write);
+void UnmapWholeFile(const uint8 *data, size_t length);
 char *NextDelim(char **s, int sep);
 char *NextLineStripComments(char **s);
 char *NextPossiblyQuotedString(char **s);
@@ -35,7 +37,14 @@ const char *SkipPrefix(const char *big, const char *little);
 void StrSet(char **rv, const char *s);
 char *StrFmt(const char *fmt, ...);
 char *ReplaceFilenameWithNewPath(const char *old_path, const char *new_path);
+int DecompressLz(uint8 *dst, MemBlk src, bool big_endian_offs);
 uint8 *ApplyBps(const uint8 *src, size_t src_size_in,
   const uint8 *bps, size_t bps_size, size_t *length_out);
 
+enum {
+  kWavHeaderSize = 44,
+};
+// Fills in the header of a 16-bit pcm wav file with |num_frames| of audio.
+void MakeWavHeader(uint8 *hdr, int freq, int channels, uint32 num_frames);
+
 #endif  // ZELDA3_UTIL_H_
\ No newline at end of file
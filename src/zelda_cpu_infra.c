@@ -60,6 +60,7 @@ static void RestoreMySnapshot(Snapshot *s) {
   memcpy(g_zenv.ram, s->ram, 0x20000);
   memcpy(g_zenv.sram, s->sram, 0x2000);
   memcpy(g_zenv.ppu->vram, s->vram, sizeof(uint16) * 0x8000);
+  VramJournal_MarkAll();
 }
 
 static void RestoreSnapshot(Snapshot *s) {
@@ -159,9 +160,17 @@ static void VerifySnapshotsEq(Snapshot *b, Snapshot *a, Snapshot *prev) {
 
   if (memcmp(b->vram, a->vram, sizeof(uint16) * 0x8000)) {
     fprintf(stderr, "@%d: VRAM compare failed (mine != theirs, prev):\n", frame_counter);
+    // Words that weren't written point at a missing upload on our side.
+    VramRange ranges[8];
+    int num_ranges = VramJournal_GetRanges(ranges, 8);
+    fprintf(stderr, "  written this frame:");
+    for (int i = 0; i < num_ranges; i++)
+      fprintf(stderr, " 0x%.4X-0x%.4X", ranges[i].start, ranges[i].end);
+    fprintf(stderr, "\n");
     for (size_t i = 0, j = 0; i < 0x8000; i++) {
       if (a->vram[i] != b->vram[i]) {
-        fprintf(stderr, "0x%.6X: %.4X != %.4X (%.4X)\n", (int)i, b->vram[i], a->vram[i], prev->vram[i]);
+        fprintf(stderr, "0x%.6X: %.4X != %.4X (%.4X)%s\n", (int)i, b->vram[i], a->vram[i], prev->vram[i],
+                VramJournal_IsDirty(i) ? "" : " not written");
         g_fail = true;
         if (++j >= 16)
           break;
@@ -348,6 +357,7 @@ again_theirs:
 
   // Run my version and snapshot
 again_mine:
+  VramJournal_Reset();
   ZeldaRunFrameInternal(input_state, run_what);
 
   MakeMySnapshot(&g_snapshot_mine);
@@ -4,6 +4,7 @@
 #include "nmi.h"
 #include "poly.h"
 #include "attract.h"
+#include "messaging.h"
 #include "snes/ppu.h"
 #include "snes/snes_regs.h"
 #include "snes/dma.h"
@@ -27,7 +28,21 @@ typedef struct SimpleHdma {
   uint8 indir_bank;
 } SimpleHdma;
 static void SimpleHdma_Init(SimpleHdma *c, DmaChannel *dc);
-static void SimpleHdma_DoLine(SimpleHdma *c);
+static int SimpleHdma_DoLine(SimpleHdma *c, uint8 *values);
+
+enum {
+  kHdmaMaxLines = 241,
+};
+
+// An hdma channel expanded into the register writes it does after each line,
+// so the tables are walked once per frame, before rendering.
+typedef struct HdmaLines {
+  const uint8 *table;  // NULL if the channel isn't active
+  uint8 mode;
+  uint8 ppu_addr;
+  uint8 num[kHdmaMaxLines];
+  uint8 values[kHdmaMaxLines][4];
+} HdmaLines;
 
 static const uint8 bAdrOffsets[8][4] = {
   {0, 0, 0, 0},
@@ -103,6 +118,7 @@ static const uint8 *SimpleHdma_GetPtr(uint32 p) {
 static void SimpleHdma_Init(SimpleHdma *c, DmaChannel *dc) {
   if (!dc->hdmaActive) {
     c->table = 0;
+    c->mode = c->ppu_addr = 0;
     return;
   }
   c->table = SimpleHdma_GetPtr(dc->aAdr | dc->aBank << 16);
@@ -112,15 +128,18 @@ static void SimpleHdma_Init(SimpleHdma *c, DmaChannel *dc) {
   c->indir_bank = dc->indBank;
 }
 
-static void SimpleHdma_DoLine(SimpleHdma *c) {
+// Stores the values the channel writes after this line in |values|, and
+// returns how many there are.
+static int SimpleHdma_DoLine(SimpleHdma *c, uint8 *values) {
   if (c->table == NULL)
-    return;
+    return 0;
   bool do_transfer = false;
+  int n = 0;
   if ((c->rep_count & 0x7f) == 0) {
     c->rep_count = *c->table++;
     if (c->rep_count == 0) {
       c->table = NULL;
-      return;
+      return 0;
     }
     if(c->mode & 0x40) {
       c->indir_ptr = SimpleHdma_GetPtr(c->indir_bank << 16 | c->table[0] | c->table[1] * 256);
@@ -129,12 +148,26 @@ static void SimpleHdma_DoLine(SimpleHdma *c) {
     do_transfer = true;
   }
   if(do_transfer || c->rep_count & 0x80) {
-    for(int j = 0, j_end = transferLength[c->mode & 7]; j < j_end; j++) {
-      uint8 v = c->mode & 0x40 ? *c->indir_ptr++ : *c->table++;
-      zelda_ppu_write(0x2100 + c->ppu_addr + bAdrOffsets[c->mode & 7][j], v);
-    }
+    for(int j_end = transferLength[c->mode & 7]; n < j_end; n++)
+      values[n] = c->mode & 0x40 ? *c->indir_ptr++ : *c->table++;
   }
   c->rep_count--;
+  return n;
+}
+
+static void HdmaLines_Compile(HdmaLines *h, DmaChannel *dc, int num_lines) {
+  SimpleHdma c;
+  SimpleHdma_Init(&c, dc);
+  h->table = c.table;
+  h->mode = c.mode;
+  h->ppu_addr = c.ppu_addr;
+  for (int i = 0; i < num_lines; i++)
+    h->num[i] = SimpleHdma_DoLine(&c, h->values[i]);
+}
+
+static void HdmaLines_Apply(const HdmaLines *h, int line) {
+  for (int j = 0; j < h->num[line]; j++)
+    zelda_ppu_write(0x2100 + h->ppu_addr + bAdrOffsets[h->mode & 7][j], h->values[line][j]);
 }
 
 static void ConfigurePpuSideSpace() {
@@ -173,14 +206,17 @@ static void ConfigurePpuSideSpace() {
 }
 
 void ZeldaDrawPpuFrame(uint8 *pixel_buffer, size_t pitch, uint32 render_flags) {
-  SimpleHdma hdma_chans[2];
+  HdmaLines hdma_chans[2];
 
   PpuBeginDrawing(g_zenv.ppu, pixel_buffer, pitch, render_flags);
 
   dma_startDma(g_zenv.dma, HDMAEN_copy, true);
 
-  SimpleHdma_Init(&hdma_chans[0], &g_zenv.dma->channel[6]);
-  SimpleHdma_Init(&hdma_chans[1], &g_zenv.dma->channel[7]);
+  int height = render_flags & kPpuRenderFlags_Height240 ? 240 : 224;
+
+  // The tables don't change while drawing, so expand them up front.
+  HdmaLines_Compile(&hdma_chans[0], &g_zenv.dma->channel[6], height + 1);
+  HdmaLines_Compile(&hdma_chans[1], &g_zenv.dma->channel[7], height + 1);
 
   // Cheat: Let the PPU impl know about the hdma perspective correction so it can avoid guessing.
   if ((render_flags & kPpuRenderFlags_4x4Mode7) && g_zenv.ppu->mode == 7) {
@@ -197,8 +233,6 @@ void ZeldaDrawPpuFrame(uint8 *pixel_buffer, size_t pitch, uint32 render_flags) {
   if (g_zenv.ppu->extraLeftRight != 0 || render_flags & kPpuRenderFlags_Height240)
     ConfigurePpuSideSpace();
 
-  int height = render_flags & kPpuRenderFlags_Height240 ? 240 : 224;
-
   for (int i = 0; i <= height; i++) {
     if (i == 128 && irq_flag) {
       zelda_ppu_write(BG3HOFS, selectfile_var8);
@@ -211,8 +245,8 @@ void ZeldaDrawPpuFrame(uint8 *pixel_buffer, size_t pitch, uint32 render_flags) {
       }
     }
     ppu_runLine(g_zenv.ppu, i);
-    SimpleHdma_DoLine(&hdma_chans[0]);
-    SimpleHdma_DoLine(&hdma_chans[1]);
+    HdmaLines_Apply(&hdma_chans[0], i);
+    HdmaLines_Apply(&hdma_chans[1], i);
   }
 }
 
@@ -262,6 +296,62 @@ static void ZeldaRunGameLoop() {
   nmi_boolean = 0;
 }
 
+static uint32 g_vram_journal[kVramJournal_NumBlocks / 32];
+
+void VramJournal_Reset() {
+  memset(g_vram_journal, 0, sizeof(g_vram_journal));
+}
+
+void VramJournal_MarkAll() {
+  memset(g_vram_journal, 0xff, sizeof(g_vram_journal));
+}
+
+void VramJournal_Mark(uint32 addr, uint32 num) {
+  if (num == 0)
+    return;
+  uint32 last = IntMin((addr + num - 1) >> kVramJournal_BlockShift, kVramJournal_NumBlocks - 1);
+  for (uint32 i = addr >> kVramJournal_BlockShift; i <= last; i++)
+    g_vram_journal[i >> 5] |= 1u << (i & 31);
+}
+
+// For writes where the address increments by 32 words, one block per word.
+void VramJournal_MarkVertical(uint32 addr, uint32 num) {
+  for (uint32 i = addr >> kVramJournal_BlockShift; num && i < kVramJournal_NumBlocks; num--, i++)
+    g_vram_journal[i >> 5] |= 1u << (i & 31);
+}
+
+bool VramJournal_IsDirty(uint32 addr) {
+  uint32 i = (addr & 0x7fff) >> kVramJournal_BlockShift;
+  return (g_vram_journal[i >> 5] >> (i & 31)) & 1;
+}
+
+// Coalesces the dirty blocks into ranges. If there are more than |max_ranges|,
+// the last one gets extended to cover the rest.
+int VramJournal_GetRanges(VramRange *ranges, int max_ranges) {
+  assert(max_ranges > 0);
+  int n = 0;
+  uint32 i = 0;
+  while (i < kVramJournal_NumBlocks) {
+    if (g_vram_journal[i >> 5] == 0) {
+      i = (i | 31) + 1;
+      continue;
+    }
+    if (!(g_vram_journal[i >> 5] >> (i & 31) & 1)) {
+      i++;
+      continue;
+    }
+    uint32 j = i + 1;
+    while (j < kVramJournal_NumBlocks && (g_vram_journal[j >> 5] >> (j & 31) & 1))
+      j++;
+    if (n == max_ranges)
+      ranges[n - 1].end = j << kVramJournal_BlockShift;
+    else
+      ranges[n++] = (VramRange) { i << kVramJournal_BlockShift, j << kVramJournal_BlockShift };
+    i = j;
+  }
+  return n;
+}
+
 void ZeldaInitialize() {
   g_zenv.dma = dma_init(NULL);
   g_zenv.ppu = ppu_init();
@@ -272,6 +362,7 @@ void ZeldaInitialize() {
   SpcPlayer_Initialize(g_zenv.player);
   dma_reset(g_zenv.dma);
   ppu_reset(g_zenv.ppu);
+  VramJournal_MarkAll();
 }
 
 static void ZeldaRunPolyLoop() {
@@ -380,6 +471,7 @@ void ZeldaReset(bool preserve_sram) {
   frame_ctr_dbg = 0;
   dma_reset(g_zenv.dma);
   ppu_reset(g_zenv.ppu);
+  VramJournal_MarkAll();
   memset(g_zenv.ram, 0, 0x20000);
   if (!preserve_sram)
     memset(g_zenv.sram, 0, 0x2000);
@@ -394,6 +486,7 @@ static void LoadSnesState(SaveLoadFunc *func, void *ctx) {
   // Do the actual loading
   ZeldaApuLock();
   InternalSaveLoad(func, ctx);
+  VramJournal_MarkAll();
   memcpy(g_zenv.ram + 0x1DBA0, g_zenv.ram + 0x1b00, 224 * 2); // hdma table was moved
 
   ZeldaRestoreMusicAfterLoad_Locked(false);
@@ -692,6 +785,14 @@ bool ZeldaRunFrame(int inputs) {
 
   frame_ctr_dbg++;
 
+  // Assets that were decompressed on demand are mostly specific to a module,
+  // so free them whenever it changes.
+  static uint8 last_module_index;
+  if (main_module_index != last_module_index) {
+    last_module_index = main_module_index;
+    ReclaimOnDemandAssets();
+  }
+
   bool is_replay = state_recorder.replay_mode;
 
   // Either copy state or apply state
@@ -769,8 +870,11 @@ void ZeldaSetLanguage(const char *language) {
       }
     }
   }
-  g_zenv.dialogue_blk = kDialogue(found.ptr[0]);
-  g_zenv.dialogue_font_blk = kDialogueFont(found.ptr[1]);
+  // Messages expanded in the old language can't be shown anymore
+  Text_ClearMessageRuns();
+  // These are kept, while the assets may be stored compressed and reclaimed.
+  g_zenv.dialogue_blk = PinAssetBlk(kDialogue(found.ptr[0]));
+  g_zenv.dialogue_font_blk = PinAssetBlk(kDialogueFont(found.ptr[1]));
   g_zenv.dialogue_flags = found.ptr[2];
 }
 
@@ -29,6 +29,23 @@ typedef struct ZeldaEnv {
 extern ZeldaEnv g_zenv;
 extern int frame_ctr_dbg;
 
+// Records which parts of vram the game wrote since the last VramJournal_Reset,
+// in blocks of 32 words, which is one tilemap row. Code that looks at vram can
+// use it to skip what didn't change. All writes to g_zenv.vram must be marked.
+enum {
+  kVramJournal_BlockShift = 5,
+  kVramJournal_NumBlocks = 0x8000 >> kVramJournal_BlockShift,
+};
+typedef struct VramRange {
+  uint32 start, end;  // in words
+} VramRange;
+void VramJournal_Reset();
+void VramJournal_MarkAll();
+void VramJournal_Mark(uint32 addr, uint32 num);
+void VramJournal_MarkVertical(uint32 addr, uint32 num);
+bool VramJournal_IsDirty(uint32 addr);
+int VramJournal_GetRanges(VramRange *ranges, int max_ranges);
+
 typedef void PlayerHandlerFunc();
 typedef void HandlerFuncK(int k);
 
@@ -55,6 +72,7 @@ void ZeldaApuUnlock();
 bool ZeldaIsPlayingMusicTrack(uint8 track);
 uint8 ZeldaGetEntranceMusicTrack(int track);
 void ZeldaSetLanguage(const char *language);
+void ZeldaSetGfxSheetCacheSize(int sheets);
 void PatchCommand(char cmd);
 
 // Things for state management